@@ -0,0 +1,224 @@
+// vim:ts=4:sw=4:expandtab
+/*
+ * Measures "battery all" with many batteries (docks, UPS and other HID
+ * devices), using the uevent files of the battery testcases. It compares the
+ * glob() and prefix comparison based parsing which print_battery_info.c did
+ * on every tick with the module itself.
+ * Run with: meson test --benchmark -v
+ *
+ */
+#include <config.h>
+#include <glob.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "i3status.h"
+
+#define BATTERIES 64
+#define ITERATIONS 2000
+
+/* Defined in i3status.c, which is not part of the benchmark. */
+int general_socket;
+cfg_t *cfg, *cfg_general, *cfg_section;
+void **cur_instance;
+uint64_t tick;
+pthread_t main_thread;
+markup_format_t markup_format = M_NONE;
+output_format_t output_format = O_NONE;
+char *pct_mark = "%";
+
+/* Keeps the compiler from optimizing the parsing away. */
+static volatile int sink;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * The parsing of print_battery_info.c before it used a lookup table, without
+ * the unit conversion, which did not change.
+ *
+ */
+static void parse_with_prefixes(const char *buf, int *total) {
+    const char *walk, *last;
+    for (walk = buf, last = buf; (walk - buf) < 1024; walk++) {
+        if (*walk == '\0')
+            break;
+        if (*walk == '\n') {
+            last = walk + 1;
+            continue;
+        }
+        if (*walk != '=')
+            continue;
+
+        if (BEGINS_WITH(last, "POWER_SUPPLY_ENERGY_NOW="))
+            *total += atoi(walk + 1);
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_CHARGE_NOW="))
+            *total += atoi(walk + 1);
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_CAPACITY="))
+            *total += atoi(walk + 1);
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_CURRENT_NOW="))
+            *total += abs(atoi(walk + 1));
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_VOLTAGE_NOW="))
+            *total += abs(atoi(walk + 1));
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_TIME_TO_EMPTY_NOW="))
+            *total += abs(atoi(walk + 1)) * 60;
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_POWER_NOW="))
+            *total += abs(atoi(walk + 1));
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Charging"))
+            *total += 1;
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Full"))
+            *total += 2;
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Discharging"))
+            *total += 3;
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Not charging"))
+            *total += 4;
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS="))
+            *total += 5;
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_CHARGE_FULL_DESIGN=") ||
+                 BEGINS_WITH(last, "POWER_SUPPLY_ENERGY_FULL_DESIGN="))
+            *total += atoi(walk + 1);
+        else if (BEGINS_WITH(last, "POWER_SUPPLY_ENERGY_FULL=") ||
+                 BEGINS_WITH(last, "POWER_SUPPLY_CHARGE_FULL="))
+            *total += atoi(walk + 1);
+    }
+}
+
+/*
+ * One tick of "battery all" before the list of batteries was cached.
+ *
+ */
+static void tick_with_glob(const char *globpath) {
+    glob_t globbuf;
+    int total = 0;
+    if (glob(globpath, 0, NULL, &globbuf) == 0) {
+        for (size_t i = 0; i < globbuf.gl_pathc; i++) {
+            char buf[1024];
+            char batpath[512];
+            sprintf(batpath, globbuf.gl_pathv[i], (int)i);
+            if (slurp_cached(batpath, buf, sizeof(buf)))
+                parse_with_prefixes(buf, &total);
+        }
+        globfree(&globbuf);
+    }
+    sink = total;
+}
+
+/*
+ * Copies the uevent files of the battery testcases into dir, repeating them
+ * until there are the given number of batteries.
+ *
+ */
+static bool write_fixtures(const char *testcases, const char *dir, int batteries) {
+    const char *patterns[] = {"*battery*/BAT0_uevent", "*battery*/uevent", "*battery*/*/uevent"};
+    glob_t globbuf;
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(*patterns); i++) {
+        char pattern[1024];
+        snprintf(pattern, sizeof(pattern), "%s/%s", testcases, patterns[i]);
+        glob(pattern, (i > 0 ? GLOB_APPEND : 0), NULL, &globbuf);
+    }
+    if (globbuf.gl_pathc == 0)
+        return false;
+
+    for (int battery = 0; battery < batteries; battery++) {
+        char uevent[1024], path[1024];
+        if (!slurp(globbuf.gl_pathv[battery % globbuf.gl_pathc], uevent, sizeof(uevent)))
+            return false;
+        snprintf(path, sizeof(path), "%s/BAT%d_uevent", dir, battery);
+        FILE *file = fopen(path, "w");
+        if (file == NULL)
+            return false;
+        fputs(uevent, file);
+        fclose(file);
+    }
+    globfree(&globbuf);
+    return true;
+}
+
+static void remove_fixtures(const char *dir, int batteries) {
+    for (int battery = 0; battery < batteries; battery++) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/BAT%d_uevent", dir, battery);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+int main(int argc, char *argv[]) {
+    const char *testcases = (argc > 1 ? argv[1] : "testcases");
+    char dir[] = "/tmp/i3status-bench-battery-XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+    if (!write_fixtures(testcases, dir, BATTERIES)) {
+        fprintf(stderr, "cannot copy the battery testcases of %s\n", testcases);
+        remove_fixtures(dir, BATTERIES);
+        return EXIT_FAILURE;
+    }
+
+    char path[1024], globpath[1024];
+    snprintf(path, sizeof(path), "%s/BAT%%d_uevent", dir);
+    snprintf(globpath, sizeof(globpath), "%s/BAT*_uevent", dir);
+
+    double start = now();
+    for (int i = 0; i < ITERATIONS; i++)
+        tick_with_glob(globpath);
+    const double glob_us = (now() - start) * 1e6 / ITERATIONS;
+
+    char buf[4096];
+    void *instance = NULL;
+    cur_instance = &instance;
+    battery_info_ctx_t ctx = {
+        .buf = buf,
+        .buflen = sizeof(buf),
+        .number = -1,
+        .path = path,
+        .format = "%status %percentage %remaining %consumption",
+        .format_down = "No battery",
+        .status_chr = "CHR",
+        .status_bat = "BAT",
+        .status_unk = "UNK",
+        .status_full = "FULL",
+        .status_idle = "IDLE",
+        .low_threshold = 10,
+        .threshold_type = "time",
+        .format_percentage = "%.02f%s",
+    };
+    /* With output_format = "none", the module prints its text to stdout. */
+    fflush(stdout);
+    const int saved_stdout = dup(STDOUT_FILENO);
+    FILE *output = tmpfile();
+    dup2(fileno(output), STDOUT_FILENO);
+    start = now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        tick++;
+        print_battery_info(&ctx);
+    }
+    const double module_us = (now() - start) * 1e6 / ITERATIONS;
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    remove_fixtures(dir, BATTERIES);
+
+    /* Every iteration printed the same text. */
+    const size_t len = ftell(output) / ITERATIONS;
+    rewind(output);
+    if (len == 0 || len >= sizeof(buf) || fread(buf, 1, len, output) != len) {
+        fprintf(stderr, "print_battery_info did not print anything\n");
+        return EXIT_FAILURE;
+    }
+    buf[len] = '\0';
+    fclose(output);
+    if (strcmp(buf, ctx.format_down) == 0) {
+        fprintf(stderr, "the batteries were not found\n");
+        return EXIT_FAILURE;
+    }
+    printf("%d batteries: glob + prefix parsing %7.1f us  print_battery_info %7.1f us  (%s)\n",
+           BATTERIES, glob_us, module_us, buf);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+// vim:ts=4:sw=4:expandtab
+/*
+ * Compares the formatters of src/format_number.c with the snprintf calls they
+ * replace in the modules. Run with: meson test --benchmark -v
+ *
+ */
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "i3status.h"
+
+#define ITERATIONS 1000000
+#define VALUES 1024
+
+static double values[VALUES];
+
+/* Keeps the compiler from optimizing the formatting away. */
+static volatile char sink;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define MEASURE(result, statement)                    \
+    do {                                              \
+        char buf[64];                                 \
+        double _start = now();                        \
+        for (int i = 0; i < ITERATIONS; i++) {        \
+            const double value = values[i % VALUES];  \
+            statement;                                \
+            sink = buf[0];                            \
+        }                                             \
+        result = (now() - _start) * 1e9 / ITERATIONS; \
+    } while (0)
+
+#define COMPARE(name, printf_statement, fast_statement)                             \
+    do {                                                                            \
+        double _printf_ns, _fast_ns;                                                \
+        MEASURE(_printf_ns, printf_statement);                                      \
+        MEASURE(_fast_ns, fast_statement);                                          \
+        printf("%-24s snprintf %6.1f ns  format_number %6.1f ns  speedup %4.1fx\n", \
+               name, _printf_ns, _fast_ns, _printf_ns / _fast_ns);                  \
+    } while (0)
+
+int main(void) {
+    srand(42);
+    for (int i = 0; i < VALUES; i++)
+        values[i] = (rand() % 100000) / 97.0;
+
+    COMPARE("cpu usage (%02d)",
+            snprintf(buf, sizeof(buf), "%02d%s", (int)value % 100, "%"),
+            stpcpy(buf + format_int(buf, (int)value % 100, 2, '0'), "%"));
+    COMPARE("load (%1.2f)",
+            snprintf(buf, sizeof(buf), "%1.2f", value / 100),
+            format_fixed(buf, sizeof(buf), value / 100, 2));
+    COMPARE("bytes (%.1f %sB)",
+            snprintf(buf, sizeof(buf), "%.1f %sB", value, "Gi"),
+            stpcpy(stpcpy(buf + format_fixed(buf, sizeof(buf), value, 1), " Gi"), "B"));
+    COMPARE("battery (%.02f%s)",
+            snprintf(buf, sizeof(buf), "%.02f%s", value / 10, "%"),
+            stpcpy(buf + format_fixed(buf, sizeof(buf), value / 10, 2), "%"));
+    COMPARE("bitrate (%g %cb/s)",
+            snprintf(buf, sizeof(buf), "%g %cb/s", value / 10, 'M'),
+            stpcpy(buf + format_general(buf, sizeof(buf), value / 10), " Mb/s"));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+// vim:ts=4:sw=4:expandtab
+/*
+ * Compares the /proc/stat parser of src/proc_stat.c with the sscanf() based
+ * parsing it replaces, using a synthetic /proc/stat of a 1024-CPU machine.
+ * Run with: meson test --benchmark -v
+ *
+ */
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "i3status.h"
+
+#define CPUS 1024
+#define ITERATIONS 2000
+
+uint64_t tick;
+
+/* Keeps the compiler from optimizing the parsing away. */
+static volatile unsigned long long sink;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Writes a /proc/stat as Linux generates it for the given number of CPUs.
+ *
+ */
+static void write_fixture(FILE *file, int cpus) {
+    const long long n = cpus;
+    fprintf(file, "cpu  %lld %lld %lld %lld %lld %lld %lld %lld 0 0\n",
+            n * 123456, n * 789, n * 45678, n * 9876543, n * 2345, n * 11, n * 4567, n * 89);
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        fprintf(file, "cpu%d %d %d %d %d %d %d %d %d 0 0\n",
+                cpu, 123456 + cpu, 789, 45678 + cpu * 3, 9876543 - cpu * 7, 2345, 11, 4567, 89);
+    }
+    fputs("intr 1234567890", file);
+    for (int irq = 0; irq < 4096; irq++)
+        fputs(" 0", file);
+    fputs("\nctxt 9876543210\nbtime 1700000000\nprocesses 1234567\nprocs_running 3\nprocs_blocked 0\n", file);
+    fputs("softirq 123456789 0 1 2 3 4 5 6 7 8 9\n", file);
+}
+
+/*
+ * The per-CPU parsing of print_cpu_usage.c before src/proc_stat.c existed.
+ *
+ */
+static void parse_with_sscanf(const char *text) {
+    static int user[CPUS], nice[CPUS], system[CPUS], idle[CPUS];
+    const char *line = strchr(text, '\n');
+    for (int i = 0; i < CPUS && line != NULL; i++, line = strchr(line, '\n')) {
+        line++;
+        int cpu, u, n, s, d;
+        if (sscanf(line, "cpu%d %d %d %d %d", &cpu, &u, &n, &s, &d) != 5 || cpu < 0 || cpu >= CPUS)
+            break;
+        user[cpu] = u;
+        nice[cpu] = n;
+        system[cpu] = s;
+        idle[cpu] = d;
+    }
+    sink = user[CPUS - 1] + nice[CPUS - 1] + system[CPUS - 1] + idle[CPUS - 1];
+}
+
+int main(void) {
+    char path[] = "/tmp/i3status-bench-stat-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    FILE *file = fdopen(fd, "w");
+    write_fixture(file, CPUS);
+    fclose(file);
+
+    size_t size = 1 << 20;
+    char *text = scalloc(size);
+    const ssize_t len = fd_cache_pread(path, text, size - 1, NULL);
+    if (len == -1 || (size_t)len == size - 1) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    double start = now();
+    for (int i = 0; i < ITERATIONS; i++)
+        parse_with_sscanf(text);
+    const double sscanf_us = (now() - start) * 1e6 / ITERATIONS;
+
+    const proc_stat_t *stat = NULL, *prev;
+    start = now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        tick++;
+        stat = proc_stat_snapshot(path, true, &prev);
+    }
+    const double snapshot_us = (now() - start) * 1e6 / ITERATIONS;
+    unlink(path);
+
+    if (stat == NULL || stat->num_cpus != CPUS || stat->ctxt != 9876543210ULL) {
+        fprintf(stderr, "the synthetic /proc/stat was not parsed correctly\n");
+        return EXIT_FAILURE;
+    }
+    printf("%d CPUs: sscanf per line (parsing only) %7.1f us  proc_stat_snapshot (read + parse) %7.1f us\n",
+           CPUS, sscanf_us, snapshot_us);
+    return EXIT_SUCCESS;
+}
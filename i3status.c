@@ -64,6 +64,8 @@ cfg_t *cfg, *cfg_general, *cfg_section;
 
 void **cur_instance;
 
+uint64_t tick;
+
 pthread_t main_thread;
 
 markup_format_t markup_format;
@@ -84,12 +86,22 @@ void fatalsig(int signum) {
 
 /*
  * Do nothing upon SIGUSR1. Running this signal handler will nevertheless
- * interrupt nanosleep() so that i3status immediately generates new output.
+ * interrupt events_wait() so that i3status immediately generates new output.
  *
  */
 void sigusr1(int signum) {
 }
 
+/*
+ * The terminal was resized, which might have wrapped the term output line.
+ * Like SIGUSR1, this interrupts events_wait() so that the line is redrawn
+ * immediately.
+ *
+ */
+void sigwinch(int signum) {
+    term_force_redraw();
+}
+
 /*
  * Checks if the given path exists by calling stat().
  *
@@ -269,6 +281,17 @@ int main(int argc, char *argv[]) {
         CFG_CUSTOM_SEP_BLOCK_WIDTH_OPT,
         CFG_END()};
 
+    cfg_opt_t process_watch_opts[] = {
+        CFG_STR("name", NULL, CFGF_NONE),
+        CFG_STR("format", "%title: %status", CFGF_NONE),
+        CFG_STR("format_down", NULL, CFGF_NONE),
+        CFG_CUSTOM_ALIGN_OPT,
+        CFG_CUSTOM_COLOR_OPTS,
+        CFG_CUSTOM_MIN_WIDTH_OPT,
+        CFG_CUSTOM_SEPARATOR_OPT,
+        CFG_CUSTOM_SEP_BLOCK_WIDTH_OPT,
+        CFG_END()};
+
     cfg_opt_t path_exists_opts[] = {
         CFG_STR("path", NULL, CFGF_NONE),
         CFG_STR("format", "%title: %status", CFGF_NONE),
@@ -416,6 +439,23 @@ int main(int argc, char *argv[]) {
         CFG_CUSTOM_SEP_BLOCK_WIDTH_OPT,
         CFG_END()};
 
+    cfg_opt_t sensor_opts[] = {
+        CFG_STR("format", "%title: %value", CFGF_NONE),
+        CFG_STR("format_down", NULL, CFGF_NONE),
+        CFG_STR("path", NULL, CFGF_NONE),
+        CFG_FLOAT("scale", 1.0, CFGF_NONE),
+        CFG_FLOAT("offset", 0.0, CFGF_NONE),
+        CFG_STR("aggregate", "max", CFGF_NONE),
+        CFG_INT("decimals", 0, CFGF_NONE),
+        CFG_STR("threshold_degraded", NULL, CFGF_NONE),
+        CFG_STR("threshold_critical", NULL, CFGF_NONE),
+        CFG_CUSTOM_ALIGN_OPT,
+        CFG_CUSTOM_COLOR_OPTS,
+        CFG_CUSTOM_MIN_WIDTH_OPT,
+        CFG_CUSTOM_SEPARATOR_OPT,
+        CFG_CUSTOM_SEP_BLOCK_WIDTH_OPT,
+        CFG_END()};
+
     cfg_opt_t disk_opts[] = {
         CFG_STR("format", "%free", CFGF_NONE),
         CFG_STR("format_below_threshold", NULL, CFGF_NONE),
@@ -448,6 +488,12 @@ int main(int argc, char *argv[]) {
         CFG_STR("format_bad", "%title - %errno: %error", CFGF_NONE),
         CFG_STR("path", NULL, CFGF_NONE),
         CFG_INT("max_characters", 255, CFGF_NONE),
+        CFG_BOOL("tail", false, CFGF_NONE),
+        CFG_STR("pattern", NULL, CFGF_NONE),
+        CFG_STR("regex", NULL, CFGF_NONE),
+        CFG_INT("threshold_capture", 1, CFGF_NONE),
+        CFG_STR("threshold_degraded", NULL, CFGF_NONE),
+        CFG_STR("threshold_critical", NULL, CFGF_NONE),
         CFG_CUSTOM_ALIGN_OPT,
         CFG_CUSTOM_COLOR_OPTS,
         CFG_CUSTOM_MIN_WIDTH_OPT,
@@ -459,11 +505,13 @@ int main(int argc, char *argv[]) {
         CFG_STR_LIST("order", "{}", CFGF_NONE),
         CFG_SEC("general", general_opts, CFGF_NONE),
         CFG_SEC("run_watch", run_watch_opts, CFGF_TITLE | CFGF_MULTI),
+        CFG_SEC("process_watch", process_watch_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("path_exists", path_exists_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("wireless", wireless_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("ethernet", ethernet_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("battery", battery_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("cpu_temperature", temp_opts, CFGF_TITLE | CFGF_MULTI),
+        CFG_SEC("sensor", sensor_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("disk", disk_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("volume", volume_opts, CFGF_TITLE | CFGF_MULTI),
         CFG_SEC("ipv6", ipv6_opts, CFGF_NONE),
@@ -502,6 +550,9 @@ int main(int argc, char *argv[]) {
     action.sa_handler = sigusr1;
     sigaction(SIGUSR1, &action, NULL);
 
+    action.sa_handler = sigwinch;
+    sigaction(SIGWINCH, &action, NULL);
+
     if (setlocale(LC_ALL, "") == NULL)
         die("Could not set locale. Please make sure all your LC_* / LANG settings are correct.\n");
 
@@ -660,15 +711,15 @@ int main(int argc, char *argv[]) {
             fprintf(stderr, "i3status: exiting due to signal.\n");
             exit(1);
         }
+        tick++;
         struct timeval tv;
         gettimeofday(&tv, NULL);
         if (output_format == O_I3BAR)
             yajl_gen_array_open(json_gen);
-        else if (output_format == O_TERM)
-            /* Restore the cursor-position, clear line */
-            printf("\033[u\033[K");
         for (j = 0; j < cfg_size(cfg, "order"); j++) {
             cur_instance = per_instance + j;
+            if (output_format == O_TERM)
+                term_start_block(j);
             if (j > 0)
                 print_separator(separator);
 
@@ -769,6 +820,21 @@ int main(int argc, char *argv[]) {
                 SEC_CLOSE_MAP;
             }
 
+            CASE_SEC_TITLE("process_watch") {
+                SEC_OPEN_MAP("process_watch");
+                process_watch_ctx_t ctx = {
+                    .json_gen = json_gen,
+                    .buf = buffer,
+                    .buflen = sizeof(buffer),
+                    .title = title,
+                    .name = cfg_getstr(sec, "name"),
+                    .format = cfg_getstr(sec, "format"),
+                    .format_down = cfg_getstr(sec, "format_down"),
+                };
+                print_process_watch(&ctx);
+                SEC_CLOSE_MAP;
+            }
+
             CASE_SEC_TITLE("path_exists") {
                 SEC_OPEN_MAP("path_exists");
                 path_exists_ctx_t ctx = {
@@ -915,6 +981,27 @@ int main(int argc, char *argv[]) {
                 SEC_CLOSE_MAP;
             }
 
+            CASE_SEC_TITLE("sensor") {
+                SEC_OPEN_MAP("sensor");
+                sensor_ctx_t ctx = {
+                    .json_gen = json_gen,
+                    .buf = buffer,
+                    .buflen = sizeof(buffer),
+                    .title = title,
+                    .path = cfg_getstr(sec, "path"),
+                    .format = cfg_getstr(sec, "format"),
+                    .format_down = cfg_getstr(sec, "format_down"),
+                    .scale = cfg_getfloat(sec, "scale"),
+                    .offset = cfg_getfloat(sec, "offset"),
+                    .aggregate = cfg_getstr(sec, "aggregate"),
+                    .decimals = cfg_getint(sec, "decimals"),
+                    .threshold_degraded = cfg_getstr(sec, "threshold_degraded"),
+                    .threshold_critical = cfg_getstr(sec, "threshold_critical"),
+                };
+                print_sensor(&ctx);
+                SEC_CLOSE_MAP;
+            }
+
             CASE_SEC("cpu_usage") {
                 SEC_OPEN_MAP("cpu_usage");
                 cpu_usage_ctx_t ctx = {
@@ -943,6 +1030,12 @@ int main(int argc, char *argv[]) {
                     .format = cfg_getstr(sec, "format"),
                     .format_bad = cfg_getstr(sec, "format_bad"),
                     .max_chars = cfg_getint(sec, "max_characters"),
+                    .tail = cfg_getbool(sec, "tail"),
+                    .pattern = cfg_getstr(sec, "pattern"),
+                    .regex = cfg_getstr(sec, "regex"),
+                    .threshold_capture = cfg_getint(sec, "threshold_capture"),
+                    .threshold_degraded = cfg_getstr(sec, "threshold_degraded"),
+                    .threshold_critical = cfg_getstr(sec, "threshold_critical"),
                 };
                 print_file_contents(&ctx);
                 SEC_CLOSE_MAP;
@@ -961,7 +1054,10 @@ int main(int argc, char *argv[]) {
             yajl_gen_clear(json_gen);
         }
 
-        printf("\n");
+        if (output_format == O_TERM)
+            term_flush_line();
+        else
+            printf("\n");
         fflush(stdout);
 
         if (run_once) {
@@ -976,7 +1072,7 @@ int main(int argc, char *argv[]) {
         struct timeval current_timeval;
         gettimeofday(&current_timeval, NULL);
         struct timespec ts = {interval - 1 - (current_timeval.tv_sec % interval), (10e5 - current_timeval.tv_usec) * 1000};
-        nanosleep(&ts, NULL);
+        events_wait(&ts);
     }
 
     yajl_gen_free(json_gen);
@@ -87,12 +87,15 @@ extern char *pct_mark;
         /* Terminate the output buffer here in any case, so that it’s                              \
          * not forgotten in the module */                                                            \
         *outwalk = '\0';                                                                             \
+        render_cache_record_text(text);                                                              \
         if (output_format == O_I3BAR) {                                                              \
             char *_markup = cfg_getstr(cfg_general, "markup");                                       \
             yajl_gen_string(ctx->json_gen, (const unsigned char *)"markup", strlen("markup"));       \
             yajl_gen_string(ctx->json_gen, (const unsigned char *)_markup, strlen(_markup));         \
             yajl_gen_string(ctx->json_gen, (const unsigned char *)"full_text", strlen("full_text")); \
             yajl_gen_string(ctx->json_gen, (const unsigned char *)text, strlen(text));               \
+        } else if (output_format == O_TERM) {                                                        \
+            term_output(text);                                                                       \
         } else {                                                                                     \
             printf("%s", text);                                                                      \
         }                                                                                            \
@@ -154,6 +157,7 @@ extern char *pct_mark;
             if (output_format == O_I3BAR) {                                                      \
                 yajl_gen_string(ctx->json_gen, (const unsigned char *)"color", strlen("color")); \
                 yajl_gen_string(ctx->json_gen, (const unsigned char *)_val, strlen(_val));       \
+                render_cache_record_color(_val);                                                 \
             } else {                                                                             \
                 outwalk += sprintf(outwalk, "%s", color(colorstr));                              \
             }                                                                                    \
@@ -167,6 +171,21 @@ extern char *pct_mark;
         }                                                                     \
     } while (0)
 
+/* Emits the block rendered on a previous tick and returns from the module
+ * when the given fingerprint of the collected values did not change. */
+#define RETURN_IF_RENDER_CACHED(fingerprint)                                                                   \
+    do {                                                                                                       \
+        const render_cache_t *_cached = render_cache_lookup(fingerprint);                                      \
+        if (_cached != NULL) {                                                                                 \
+            if (output_format == O_I3BAR && _cached->color != NULL) {                                          \
+                yajl_gen_string(ctx->json_gen, (const unsigned char *)"color", strlen("color"));               \
+                yajl_gen_string(ctx->json_gen, (const unsigned char *)_cached->color, strlen(_cached->color)); \
+            }                                                                                                  \
+            OUTPUT_FULL_TEXT(_cached->full_text);                                                              \
+            return;                                                                                            \
+        }                                                                                                      \
+    } while (0)
+
 #define INSTANCE(instance)                                                                         \
     do {                                                                                           \
         if (output_format == O_I3BAR) {                                                            \
@@ -197,19 +216,119 @@ void die(const char *fmt, ...) __attribute__((format(printf, 1, 2), noreturn));
 bool slurp(const char *filename, char *destination, int size);
 char *resolve_tilde(const char *path);
 void *scalloc(size_t size);
+void *srealloc(void *ptr, size_t size);
 char *sstrdup(const char *str);
+const char *threshold_color(double value, const char *threshold_degraded, const char *threshold_critical);
+
+/* src/fd_cache.c */
+ssize_t fd_cache_pread(const char *path, char *buf, size_t size, bool *opened);
+void fd_cache_invalidate(const char *prefix);
+bool slurp_cached(const char *filename, char *destination, int size);
+
+/* src/events.c */
+/* Called when the watched file descriptor is readable. Returns whether
+ * something changed which should be shown right away. */
+typedef bool (*event_callback_t)(int fd, void *data);
+
+void events_watch(int fd, event_callback_t callback, void *data);
+void events_watch_priority(int fd, event_callback_t callback, void *data);
+void events_unwatch(int fd);
+void events_wait(const struct timespec *timeout);
+
+/* src/uevents.c */
+/* Counts the uevents of a subsystem, see uevents_watch(). */
+typedef struct {
+    /* Incremented for every event, e.g. a battery which starts charging. */
+    unsigned int changes;
+    /* Incremented when a device is added or removed. */
+    unsigned int hotplugs;
+} uevent_counts_t;
+
+bool uevents_watch(const char *subsystem, uevent_counts_t *counts, bool redraw);
+
+/* src/file_watch.c */
+bool file_watch(const char *path, bool pattern, unsigned int *changes);
+
+/* src/proc_stat.c */
+/* The time spent in each state as listed in /proc/stat, in USER_HZ. Guest
+ * time is accounted as user time as well. */
+typedef struct {
+    unsigned long long user;
+    unsigned long long nice;
+    unsigned long long system;
+    unsigned long long idle;
+    unsigned long long iowait;
+    unsigned long long irq;
+    unsigned long long softirq;
+    unsigned long long steal;
+    unsigned long long guest;
+    unsigned long long guest_nice;
+} cpu_times_t;
+
+typedef struct {
+    /* When the snapshot was taken (CLOCK_MONOTONIC). */
+    struct timespec time;
+    cpu_times_t all;
+    /* The times of each CPU, indexed by CPU number. Only filled in when the
+     * per-CPU lines were requested. Offline CPUs keep the times they had
+     * when they went offline. */
+    bool has_cpus;
+    cpu_times_t *cpus;
+    bool *online;
+    int cpus_size;
+    /* The number of per-CPU lines, i.e. of online CPUs. */
+    int num_cpus;
+    unsigned long long ctxt;
+    unsigned long long processes;
+    unsigned long long procs_running;
+    unsigned long long procs_blocked;
+} proc_stat_t;
+
+const proc_stat_t *proc_stat_snapshot(const char *path, bool per_cpu, const proc_stat_t **previous);
+unsigned long long cpu_times_total(const cpu_times_t *times);
+unsigned long long cpu_times_idle(const cpu_times_t *times);
 
 /* src/output.c */
 void print_separator(const char *separator);
 char *color(const char *colorstr);
 char *endcolor() __attribute__((pure));
 void reset_cursor(void);
+void term_start_block(int index);
+void term_output(const char *text);
+void term_force_redraw(void);
+void term_flush_line(void);
 void maybe_escape_markup(char *text, char *buffer, size_t size);
 
 char *rtrim(const char *s);
 char *ltrim(const char *s);
 char *trim(const char *s);
 
+/* src/format_number.c */
+int format_int(char *buf, long long value, int width, char pad);
+long long fixed_point(double value, int decimals);
+int format_fixed(char *buf, size_t size, double value, int decimals);
+int format_general(char *buf, size_t size, double value);
+
+/* src/render_cache.c */
+typedef struct {
+    bool valid;
+    uint64_t fingerprint;
+    /* The color value as sent to i3bar, NULL if the block was not colored. */
+    const char *color;
+    char *full_text;
+    size_t text_size;
+} render_cache_t;
+
+#define FINGERPRINT_INIT UINT64_C(14695981039346656037)
+#define FINGERPRINT(fingerprint, var) ((fingerprint) = fingerprint_bytes((fingerprint), &(var), sizeof(var)))
+
+uint64_t fingerprint_bytes(uint64_t fingerprint, const void *data, size_t len);
+uint64_t fingerprint_str(uint64_t fingerprint, const char *str);
+uint64_t fingerprint_rounded(uint64_t fingerprint, double value, int decimals);
+const render_cache_t *render_cache_lookup(uint64_t fingerprint);
+void render_cache_record_color(const char *color);
+void render_cache_record_text(const char *text);
+
 // copied from  i3:libi3/format_placeholders.c
 /* src/format_placeholders.c */
 typedef struct {
@@ -219,6 +338,12 @@ typedef struct {
     const char *value;
 } placeholder_t;
 char *format_placeholders(const char *format, placeholder_t *placeholders, int num);
+bool formats_use_placeholder(const char *placeholder, const char *const *formats, int num);
+
+/* Whether any of the given formats references the placeholder, e.g.
+ * FORMATS_USE("%speed", ctx->format_up, ctx->format_down). */
+#define FORMATS_USE(placeholder, ...) \
+    formats_use_placeholder((placeholder), (const char *const[]){__VA_ARGS__}, sizeof((const char *const[]){__VA_ARGS__}) / sizeof(const char *))
 
 /* src/auto_detect_format.c */
 char *auto_detect_format();
@@ -234,6 +359,28 @@ typedef enum {
 } net_type_t;
 const char *first_eth_interface(const net_type_t type);
 
+/* src/rtnetlink.c */
+typedef struct {
+    int index;
+    /* IF_NAMESIZE bytes */
+    char name[16];
+    /* IFF_UP, IFF_RUNNING, IFF_LOOPBACK, … */
+    unsigned int flags;
+} net_link_t;
+
+typedef struct {
+    /* The index of the interface. */
+    int index;
+    /* AF_INET or AF_INET6, and the address in network byte order. */
+    int family;
+    unsigned char address[16];
+    unsigned char prefixlen;
+} net_address_t;
+
+bool rtnetlink_links(const net_link_t **links, int *num_links);
+bool rtnetlink_addresses(const net_address_t **addresses, int *num_addresses);
+bool rtnetlink_generation(unsigned int *generation);
+
 typedef struct {
     yajl_gen json_gen;
     char *buf;
@@ -335,6 +482,18 @@ typedef struct {
 
 void print_run_watch(run_watch_ctx_t *ctx);
 
+typedef struct {
+    yajl_gen json_gen;
+    char *buf;
+    const size_t buflen;
+    const char *title;
+    const char *name;
+    const char *format;
+    const char *format_down;
+} process_watch_ctx_t;
+
+void print_process_watch(process_watch_ctx_t *ctx);
+
 typedef struct {
     yajl_gen json_gen;
     char *buf;
@@ -360,6 +519,24 @@ typedef struct {
 
 void print_cpu_temperature_info(cpu_temperature_ctx_t *ctx);
 
+typedef struct {
+    yajl_gen json_gen;
+    char *buf;
+    const size_t buflen;
+    const char *title;
+    const char *path;
+    const char *format;
+    const char *format_down;
+    const double scale;
+    const double offset;
+    const char *aggregate;
+    const int decimals;
+    const char *threshold_degraded;
+    const char *threshold_critical;
+} sensor_ctx_t;
+
+void print_sensor(sensor_ctx_t *ctx);
+
 typedef struct {
     yajl_gen json_gen;
     char *buf;
@@ -425,6 +602,7 @@ typedef struct {
 void print_volume(volume_ctx_t *ctx);
 
 bool process_runs(const char *path);
+int process_count(const char *name);
 int volume_pulseaudio(uint32_t sink_idx, const char *sink_name);
 bool description_pulseaudio(uint32_t sink_idx, const char *sink_name, char buffer[MAX_SINK_DESCRIPTION_LEN]);
 bool pulse_initialize(void);
@@ -438,6 +616,12 @@ typedef struct {
     const char *format;
     const char *format_bad;
     const int max_chars;
+    const bool tail;
+    const char *pattern;
+    const char *regex;
+    const int threshold_capture;
+    const char *threshold_degraded;
+    const char *threshold_critical;
 } file_contents_ctx_t;
 
 void print_file_contents(file_contents_ctx_t *ctx);
@@ -449,5 +633,9 @@ extern cfg_t *cfg, *cfg_general, *cfg_section;
 
 extern void **cur_instance;
 
+/* Counts the lines i3status has generated, so that data which is shared
+ * between instances can be collected once per line. */
+extern uint64_t tick;
+
 extern pthread_t main_thread;
 #endif
@@ -0,0 +1,110 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "i3status.h"
+
+/*
+ * Modules which get notified about changes (e.g. by the kernel through a
+ * netlink socket) register their file descriptor here. While i3status waits
+ * for the next update, the callbacks are run as soon as their file descriptor
+ * becomes readable, and when one of them reports a relevant change, the next
+ * line is generated right away.
+ *
+ */
+typedef struct {
+    event_callback_t callback;
+    void *data;
+} event_watch_t;
+
+static struct pollfd *pollfds = NULL;
+static event_watch_t *watches = NULL;
+static int num_watches = 0;
+
+static void watch_fd(int fd, short events, event_callback_t callback, void *data) {
+    pollfds = srealloc(pollfds, (num_watches + 1) * sizeof(struct pollfd));
+    watches = srealloc(watches, (num_watches + 1) * sizeof(event_watch_t));
+    pollfds[num_watches] = (struct pollfd){.fd = fd, .events = events};
+    watches[num_watches] = (event_watch_t){.callback = callback, .data = data};
+    num_watches++;
+}
+
+/*
+ * Calls callback whenever fd is readable while i3status is waiting.
+ *
+ */
+void events_watch(int fd, event_callback_t callback, void *data) {
+    watch_fd(fd, POLLIN, callback, data);
+}
+
+/*
+ * Calls callback whenever fd signals priority data (POLLPRI) while i3status is
+ * waiting. Some files in /proc, like /proc/self/mountinfo, are always readable
+ * and signal changes this way.
+ *
+ */
+void events_watch_priority(int fd, event_callback_t callback, void *data) {
+    watch_fd(fd, POLLPRI, callback, data);
+}
+
+/*
+ * Stops watching fd. The file descriptor is not closed.
+ *
+ */
+void events_unwatch(int fd) {
+    for (int i = 0; i < num_watches; i++) {
+        if (pollfds[i].fd != fd)
+            continue;
+        num_watches--;
+        pollfds[i] = pollfds[num_watches];
+        watches[i] = watches[num_watches];
+        return;
+    }
+}
+
+static long long milliseconds_until(const struct timespec *deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (deadline->tv_sec - now.tv_sec) * 1000LL + (deadline->tv_nsec - now.tv_nsec + 999999) / 1000000;
+}
+
+/*
+ * Sleeps for the given time, like nanosleep(). Returns early when a signal
+ * arrives (e.g. SIGUSR1) or when a callback of a watched file descriptor
+ * returns true.
+ *
+ */
+void events_wait(const struct timespec *timeout) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout->tv_sec;
+    deadline.tv_nsec += timeout->tv_nsec;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+    }
+
+    long long remaining;
+    while ((remaining = milliseconds_until(&deadline)) > 0) {
+        if (poll(pollfds, num_watches, (remaining > INT_MAX ? INT_MAX : remaining)) == -1)
+            return;
+
+        bool changed = false;
+        for (int i = 0; i < num_watches; i++) {
+            if (pollfds[i].revents == 0)
+                continue;
+            const int fd = pollfds[i].fd;
+            /* The callback may unwatch its file descriptor. */
+            if (watches[i].callback(fd, watches[i].data))
+                changed = true;
+            if (i < num_watches && pollfds[i].fd != fd)
+                i--;
+        }
+        if (changed)
+            return;
+    }
+}
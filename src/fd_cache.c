@@ -0,0 +1,134 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#endif
+
+#include "i3status.h"
+
+/*
+ * Files in procfs and sysfs are generated on every read, so they can be kept
+ * open and re-read with pread() instead of being looked up and opened on
+ * every tick. Files on other filesystems might be replaced (e.g. by rename())
+ * and are opened again for every read.
+ *
+ */
+typedef struct {
+    char *path;
+    int fd;
+} cached_fd_t;
+
+static cached_fd_t *cached_fds = NULL;
+static int num_cached_fds = 0;
+
+static cached_fd_t *find_cached_fd(const char *path) {
+    for (int i = 0; i < num_cached_fds; i++) {
+        if (strcmp(cached_fds[i].path, path) == 0)
+            return &cached_fds[i];
+    }
+    return NULL;
+}
+
+static void close_cached_fd(cached_fd_t *entry) {
+    (void)close(entry->fd);
+    free(entry->path);
+    *entry = cached_fds[--num_cached_fds];
+}
+
+/*
+ * Whether the file behind fd is generated by the kernel on every read.
+ *
+ */
+static bool is_generated(int fd) {
+#if defined(__linux__)
+    struct statfs buf;
+    if (fstatfs(fd, &buf) == -1)
+        return false;
+    return buf.f_type == PROC_SUPER_MAGIC || buf.f_type == SYSFS_MAGIC;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Reads up to size bytes from the beginning of the given file. Files in
+ * procfs and sysfs stay open for the next call.
+ *
+ * Returns the number of bytes read or -1 with errno set. When opened is not
+ * NULL, it is set to whether the file could be opened, so that callers can
+ * tell a missing file from a failed read.
+ *
+ */
+ssize_t fd_cache_pread(const char *path, char *buf, size_t size, bool *opened) {
+    cached_fd_t *entry = find_cached_fd(path);
+    if (entry != NULL) {
+        ssize_t n = pread(entry->fd, buf, size, 0);
+        if (n != -1 || (errno != ENODEV && errno != ESTALE)) {
+            if (opened != NULL)
+                *opened = true;
+            return n;
+        }
+        /* The device went away (e.g. an unplugged battery). Another one might
+         * have taken its place, so the path is opened again. */
+        close_cached_fd(entry);
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (opened != NULL)
+        *opened = (fd != -1);
+    if (fd == -1)
+        return -1;
+
+    ssize_t n = pread(fd, buf, size, 0);
+    if (n == -1 && errno == ESPIPE) {
+        /* FIFOs and many character devices cannot be read at an offset.
+         * They are not kept open either, see is_generated(). */
+        n = read(fd, buf, size);
+    }
+    if (n == -1 || !is_generated(fd)) {
+        const int read_errno = errno;
+        (void)close(fd);
+        errno = read_errno;
+        return n;
+    }
+
+    cached_fds = srealloc(cached_fds, (num_cached_fds + 1) * sizeof(cached_fd_t));
+    cached_fds[num_cached_fds++] = (cached_fd_t){.path = sstrdup(path), .fd = fd};
+    return n;
+}
+
+/*
+ * Closes the cached files whose path begins with the given prefix (e.g. the
+ * directory of a device which was unplugged), so that they are opened again
+ * on the next read, possibly for a different device.
+ *
+ */
+void fd_cache_invalidate(const char *prefix) {
+    const size_t len = strlen(prefix);
+    /* close_cached_fd() moves the last entry into the closed one's place. */
+    for (int i = num_cached_fds - 1; i >= 0; i--) {
+        if (strncmp(cached_fds[i].path, prefix, len) == 0)
+            close_cached_fd(&cached_fds[i]);
+    }
+}
+
+/*
+ * Like slurp(), but keeps files in procfs and sysfs open (see
+ * fd_cache_pread()).
+ *
+ */
+bool slurp_cached(const char *filename, char *destination, int size) {
+    /* We need one byte for the trailing 0 byte */
+    ssize_t n = fd_cache_pread(filename, destination, size - 1, NULL);
+    if (n == -1)
+        return false;
+    destination[n] = '\0';
+    return true;
+}
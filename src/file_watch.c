@@ -0,0 +1,345 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <fnmatch.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#endif
+
+#include "i3status.h"
+
+/*
+ * Modules which look at files (e.g. path_exists) register the paths here and
+ * get changes counted, so that they only look at the filesystem again when
+ * something happened.
+ *
+ * The nearest existing ancestor of a path is watched with inotify: the parent
+ * directory if it exists, otherwise the deepest directory above it. When the
+ * next directory on the way to the path appears, the watch moves down to it.
+ * The directories above are only watched for being moved or removed. When
+ * that happens, or something is mounted or unmounted, the watches are set up
+ * again.
+ *
+ */
+#if defined(__linux__)
+/* Changes made by other machines on network filesystems are not reported by
+ * inotify, so paths on those are checked again after this many seconds.
+ * Paths in filesystems generated by the kernel are not watched at all. */
+#define REMOTE_RECHECK_INTERVAL 30
+
+/* The events which indicate that a directory entry was created, written,
+ * replaced or removed, or that the directory itself went away. */
+#define WATCH_EVENTS (IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE | \
+                      IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+typedef enum {
+    FS_LOCAL,
+    /* Network filesystems, where inotify only sees changes made locally. */
+    FS_REMOTE,
+    /* Filesystems generated by the kernel (e.g. /proc), where inotify does
+     * not see any changes. */
+    FS_GENERATED,
+} filesystem_kind_t;
+
+typedef struct {
+    char *path;
+    /* Whether the last component of path is a pattern for fnmatch(). */
+    bool pattern;
+    unsigned int *changes;
+    /* The inotify watch of the nearest existing ancestor, -1 if none. */
+    int wd;
+    /* The inotify watches of the directories above it. */
+    int *ancestors;
+    int num_ancestors;
+    /* The name in the watched directory which leads to path, and whether it
+     * is the last component of path (i.e. the parent is watched). */
+    char *next;
+    bool parent;
+    /* The filesystem of the watched directory, and for network filesystems,
+     * when path was last reported as changed. */
+    filesystem_kind_t kind;
+    time_t rechecked;
+} file_watch_t;
+
+static file_watch_t *watches = NULL;
+static int num_watches = 0;
+
+/* The inotify instance, or -1 if inotify cannot be used. */
+static int inotify_fd = -1;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static filesystem_kind_t filesystem_kind(const char *dir) {
+    static const struct {
+        long type;
+        filesystem_kind_t kind;
+    } kinds[] = {
+        {0x6969, FS_REMOTE},        /* NFS */
+        {0x517b, FS_REMOTE},        /* SMB */
+        {0xfe534d42, FS_REMOTE},    /* SMB2 */
+        {0xff534d42, FS_REMOTE},    /* CIFS */
+        {0x65735546, FS_REMOTE},    /* FUSE (e.g. sshfs) */
+        {0x00c36400, FS_REMOTE},    /* Ceph */
+        {0x5346414f, FS_REMOTE},    /* AFS */
+        {0x01021997, FS_REMOTE},    /* 9p */
+        {0x9fa0, FS_GENERATED},     /* proc */
+        {0x62656572, FS_GENERATED}, /* sysfs */
+        {0x27e0eb, FS_GENERATED},   /* cgroup */
+        {0x63677270, FS_GENERATED}, /* cgroup2 */
+        {0x64626720, FS_GENERATED}, /* debugfs */
+        {0x74726163, FS_GENERATED}, /* tracefs */
+        {0x73636673, FS_GENERATED}, /* securityfs */
+        {0xde5e81e4, FS_GENERATED}, /* efivarfs */
+    };
+    struct statfs buf;
+    if (statfs(dir, &buf) == -1)
+        return FS_LOCAL;
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        if ((long)buf.f_type == kinds[i].type)
+            return kinds[i].kind;
+    }
+    return FS_LOCAL;
+}
+
+static bool uses_wd(const file_watch_t *watch, int wd) {
+    if (watch->wd == wd)
+        return true;
+    for (int i = 0; i < watch->num_ancestors; i++) {
+        if (watch->ancestors[i] == wd)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Removes the inotify watches of the given entry, except those of
+ * directories which other entries watch as well (inotify returns the same
+ * watch for them).
+ *
+ */
+static void unwatch(file_watch_t *watch) {
+    const file_watch_t old = *watch;
+    watch->wd = -1;
+    watch->num_ancestors = 0;
+    for (int i = -1; i < old.num_ancestors; i++) {
+        const int wd = (i == -1 ? old.wd : old.ancestors[i]);
+        bool shared = false;
+        for (int j = 0; j < num_watches && !shared; j++)
+            shared = uses_wd(&watches[j], wd);
+        if (wd != -1 && !shared)
+            (void)inotify_rm_watch(inotify_fd, wd);
+    }
+}
+
+/*
+ * Watches the directories above dir for being moved or removed.
+ *
+ */
+static void watch_ancestors(file_watch_t *watch, const char *dir) {
+    char *ancestor = sstrdup(dir);
+    char *slash;
+    while ((slash = strrchr(ancestor, '/')) != NULL && slash != ancestor) {
+        *slash = '\0';
+        const int wd = inotify_add_watch(inotify_fd, ancestor, IN_DELETE_SELF | IN_MOVE_SELF | IN_MASK_ADD | IN_ONLYDIR);
+        if (wd == -1)
+            continue;
+        watch->ancestors = srealloc(watch->ancestors, (watch->num_ancestors + 1) * sizeof(int));
+        watch->ancestors[watch->num_ancestors++] = wd;
+    }
+    free(ancestor);
+}
+
+/*
+ * Watches the nearest existing ancestor of path.
+ *
+ */
+static void arm(file_watch_t *watch) {
+    unwatch(watch);
+    free(watch->next);
+    watch->next = NULL;
+
+    char *prefix = sstrdup(watch->path);
+    watch->parent = true;
+    while (true) {
+        size_t len = strlen(prefix);
+        while (len > 1 && prefix[len - 1] == '/')
+            prefix[--len] = '\0';
+
+        const char *dir;
+        char *slash = strrchr(prefix, '/');
+        if (slash == NULL) {
+            dir = ".";
+            free(watch->next);
+            watch->next = sstrdup(prefix);
+        } else {
+            free(watch->next);
+            watch->next = sstrdup(slash + 1);
+            if (slash == prefix)
+                slash++;
+            *slash = '\0';
+            dir = prefix;
+        }
+
+        /* Other entries may watch the same directory for other events. */
+        watch->wd = inotify_add_watch(inotify_fd, dir, WATCH_EVENTS | IN_MASK_ADD | IN_ONLYDIR);
+        if (watch->wd != -1) {
+            watch->kind = filesystem_kind(dir);
+            watch_ancestors(watch, dir);
+            break;
+        }
+        /* Go up until an existing directory is found. */
+        if ((errno != ENOENT && errno != ENOTDIR) || strcmp(dir, ".") == 0 || strcmp(dir, "/") == 0)
+            break;
+        watch->parent = false;
+    }
+    free(prefix);
+}
+
+static bool name_matches(const file_watch_t *watch, const char *name) {
+    if (strcmp(watch->next, name) == 0)
+        return true;
+    return (watch->parent && watch->pattern && fnmatch(watch->next, name, 0) == 0);
+}
+
+/*
+ * Reads the pending inotify events and counts the changes of the watched
+ * paths. Returns whether one of them should be shown right away.
+ *
+ */
+static bool read_inotify_events(int fd, void *data) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        const struct inotify_event *event;
+        for (char *walk = buf; walk < buf + n; walk += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event *)walk;
+            for (int i = 0; i < num_watches; i++) {
+                file_watch_t *watch = &watches[i];
+                if (event->mask & IN_Q_OVERFLOW) {
+                    /* Events were dropped, so anything might have changed. */
+                    arm(watch);
+                } else if (!uses_wd(watch, event->wd)) {
+                    continue;
+                } else if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    /* A watched directory is gone. */
+                    arm(watch);
+                } else if (watch->wd != event->wd) {
+                    /* Another entry watches this directory for its entries. */
+                    continue;
+                } else if (event->len == 0 || watch->next == NULL || !name_matches(watch, event->name)) {
+                    continue;
+                } else if (!watch->parent) {
+                    /* The next directory on the way to path appeared (or
+                     * path itself, if it was created with its parents). */
+                    arm(watch);
+                }
+                (*watch->changes)++;
+                /* A file which is being written (e.g. just truncated by the
+                 * shell) is shown once it is closed, or on the next update
+                 * if the writer keeps it open. */
+                if (event->mask != IN_MODIFY)
+                    changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+/*
+ * Called when something was mounted or unmounted, which inotify does not
+ * report.
+ *
+ */
+static bool mounts_changed(int fd, void *data) {
+    for (int i = 0; i < num_watches; i++) {
+        arm(&watches[i]);
+        (*watches[i].changes)++;
+    }
+    return (num_watches > 0);
+}
+
+static bool open_inotify(void) {
+    static bool opened = false;
+    if (opened)
+        return (inotify_fd != -1);
+    opened = true;
+
+    if ((inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1)
+        return false;
+    events_watch(inotify_fd, read_inotify_events, NULL);
+
+    int mounts_fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (mounts_fd != -1)
+        events_watch_priority(mounts_fd, mounts_changed, NULL);
+    return true;
+}
+#endif
+
+/*
+ * Counts the changes of path (it being created, written, replaced or removed)
+ * in changes. When pattern is set, the last component of path is a pattern
+ * for fnmatch() and all matching files are watched. Calling this again with
+ * the same arguments does nothing, so modules can call it on every update.
+ *
+ * Returns false if path cannot be watched right now, in which case modules
+ * have to look at it themselves.
+ *
+ */
+bool file_watch(const char *path, bool pattern, unsigned int *changes) {
+#if defined(__linux__)
+    if (!open_inotify())
+        return false;
+
+    file_watch_t *watch = NULL;
+    for (int i = 0; i < num_watches; i++) {
+        if (watches[i].changes == changes && watches[i].pattern == pattern && strcmp(watches[i].path, path) == 0) {
+            watch = &watches[i];
+            break;
+        }
+    }
+    if (watch == NULL) {
+        /* Patterns are only supported in the last component. */
+        if (pattern) {
+            const char *slash = strrchr(path, '/');
+            if (slash != NULL && strcspn(path, "*?[") < (size_t)(slash - path))
+                return false;
+        }
+        watches = srealloc(watches, (num_watches + 1) * sizeof(file_watch_t));
+        watch = &watches[num_watches++];
+        *watch = (file_watch_t){.path = sstrdup(path), .pattern = pattern, .changes = changes, .wd = -1};
+        watch->rechecked = monotonic_seconds();
+    }
+
+    /* A watch which could not be set up (e.g. too many watches) is tried
+     * again on every update. */
+    if (watch->wd == -1)
+        arm(watch);
+    if (watch->wd == -1)
+        return false;
+
+    if (watch->kind == FS_GENERATED)
+        return false;
+    if (watch->kind == FS_REMOTE) {
+        const time_t now = monotonic_seconds();
+        if (now - watch->rechecked >= REMOTE_RECHECK_INTERVAL) {
+            watch->rechecked = now;
+            (*changes)++;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
@@ -154,7 +154,89 @@ static net_type_t iface_type(const char *ifname) {
     return NET_TYPE_OTHER;
 }
 
-const char *first_eth_interface(const net_type_t type) {
+#if defined(__linux__)
+/*
+ * The type of an interface and whether it is virtual do not change, so they
+ * are looked up in sysfs once for every interface in the netlink table.
+ *
+ */
+typedef struct {
+    int index;
+    char name[16];
+    net_type_t type;
+    bool is_virtual;
+} link_class_t;
+
+static link_class_t *link_classes = NULL;
+static int num_link_classes = 0;
+
+static const link_class_t *classify_link(const net_link_t *link) {
+    link_class_t *class = NULL;
+    for (int i = 0; i < num_link_classes; i++) {
+        if (link_classes[i].index != link->index)
+            continue;
+        if (strcmp(link_classes[i].name, link->name) == 0)
+            return &link_classes[i];
+        /* The interface was renamed, or its index reused. */
+        class = &link_classes[i];
+        break;
+    }
+    if (class == NULL) {
+        link_classes = srealloc(link_classes, (num_link_classes + 1) * sizeof(link_class_t));
+        class = &link_classes[num_link_classes++];
+    }
+    class->index = link->index;
+    snprintf(class->name, sizeof(class->name), "%s", link->name);
+    class->type = iface_type(link->name);
+    class->is_virtual = is_virtual(link->name);
+    return class;
+}
+
+static bool has_address(int index, int family, const net_address_t *addresses, int num_addresses) {
+    for (int i = 0; i < num_addresses; i++) {
+        if (addresses[i].index == index && addresses[i].family == family)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Looks for the first interface of the given type in the netlink table. Like
+ * with getifaddrs(), interfaces with an IPv4 address come first. Returns false
+ * if the table is not available.
+ *
+ */
+static bool first_rtnetlink_interface(const net_type_t type, char *name, size_t size) {
+    const net_link_t *links;
+    const net_address_t *addresses;
+    int num_links, num_addresses;
+    if (!rtnetlink_links(&links, &num_links) || !rtnetlink_addresses(&addresses, &num_addresses))
+        return false;
+
+    name[0] = '\0';
+    const int families[] = {AF_INET, AF_INET6};
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+        for (int i = 0; i < num_links; i++) {
+            if (strncasecmp(LOOPBACK_DEV, links[i].name, strlen(LOOPBACK_DEV)) == 0)
+                continue;
+            if (!has_address(links[i].index, families[f], addresses, num_addresses))
+                continue;
+            const link_class_t *class = classify_link(&links[i]);
+            if (class->type != type || class->is_virtual)
+                continue;
+            snprintf(name, size, "%s", links[i].name);
+            return true;
+        }
+    }
+    return true;
+}
+#endif
+
+/*
+ * Looks for the first interface of the given type with getifaddrs().
+ *
+ */
+static const char *first_ifaddrs_interface(const net_type_t type) {
     static char *interface = NULL;
     struct ifaddrs *ifaddr, *addrp;
     net_type_t iftype;
@@ -196,3 +278,18 @@ const char *first_eth_interface(const net_type_t type) {
     freeifaddrs(ifaddr);
     return interface;
 }
+
+/*
+ * Returns the name of the first interface of the given type which has an
+ * address, or NULL. On Linux, this is looked up in the table of interfaces
+ * which is kept up to date through netlink.
+ *
+ */
+const char *first_eth_interface(const net_type_t type) {
+#if defined(__linux__)
+    static char names[NET_TYPE_OTHER + 1][16];
+    if (first_rtnetlink_interface(type, names[type], sizeof(names[type])))
+        return (names[type][0] != '\0' ? names[type] : NULL);
+#endif
+    return first_ifaddrs_interface(type);
+}
@@ -0,0 +1,199 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <locale.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "i3status.h"
+
+/* Scaled values at or above this do not fit into a long long, so they are
+ * handed to printf. */
+#define FIXED_LIMIT 9e18
+
+static const double powers_of_ten[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+#define MAX_DECIMALS ((int)(sizeof(powers_of_ten) / sizeof(*powers_of_ten)) - 1)
+
+/*
+ * Returns the decimal point of the current locale, as used by printf. The
+ * locale is set once at startup, so it is looked up only once.
+ *
+ */
+static const char *decimal_point(void) {
+    static char point[8] = "";
+    if (point[0] == '\0')
+        snprintf(point, sizeof(point), "%s", localeconv()->decimal_point);
+    return point;
+}
+
+/*
+ * Writes the decimal digits of value right-aligned in front of end and returns
+ * a pointer to the first digit.
+ *
+ */
+static char *reverse_digits(char *end, unsigned long long value) {
+    do {
+        *(--end) = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+    return end;
+}
+
+/*
+ * Formats an integer like printf("%*lld") or, when pad is '0', like
+ * printf("%0*lld"). Returns the number of bytes written, not counting the
+ * terminating NUL byte.
+ *
+ */
+int format_int(char *buf, long long value, int width, char pad) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    const bool negative = (value < 0);
+    unsigned long long magnitude = negative ? -(unsigned long long)value : (unsigned long long)value;
+    char *start = reverse_digits(end, magnitude);
+    int len = end - start;
+
+    char *walk = buf;
+    int padding = width - len - (negative ? 1 : 0);
+    if (pad != '0') {
+        for (; padding > 0; padding--)
+            *(walk++) = pad;
+    }
+    if (negative)
+        *(walk++) = '-';
+    if (pad == '0') {
+        for (; padding > 0; padding--)
+            *(walk++) = '0';
+    }
+    memcpy(walk, start, len);
+    walk += len;
+    *walk = '\0';
+    return walk - buf;
+}
+
+/*
+ * Returns value * 10^decimals rounded to the nearest integer, which is what
+ * format_fixed() displays.
+ *
+ */
+long long fixed_point(double value, int decimals) {
+    if (decimals > MAX_DECIMALS)
+        decimals = MAX_DECIMALS;
+    const double scaled = value * powers_of_ten[decimals];
+    const double below = floor(scaled);
+    if (scaled - below == 0.5) {
+        /* The product itself was rounded, which matters when it ended up
+         * exactly halfway between two integers: printf rounds the exact
+         * value, so the rounding error decides the direction. */
+        const double error = fma(value, powers_of_ten[decimals], -scaled);
+        if (error != 0)
+            return (long long)below + (error > 0 ? 1 : 0);
+    }
+    return llrint(scaled);
+}
+
+/*
+ * Like snprintf(), but returns the number of bytes actually written (not
+ * counting the terminating NUL byte), so that it can be used to advance a
+ * pointer into buf.
+ *
+ */
+static int bounded_printf(char *buf, size_t size, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(buf, size, format, args);
+    va_end(args);
+    if (len < 0 || size == 0)
+        return 0;
+    return ((size_t)len >= size ? (int)size - 1 : len);
+}
+
+/*
+ * Formats a floating point value like printf("%.*f"), including the
+ * locale's decimal point, into a buffer of the given size. Returns the number
+ * of bytes written, not counting the terminating NUL byte.
+ *
+ */
+int format_fixed(char *buf, size_t size, double value, int decimals) {
+    if (decimals < 0)
+        decimals = 0;
+    if (!isfinite(value) || decimals > MAX_DECIMALS || fabs(value) * powers_of_ten[decimals] >= FIXED_LIMIT)
+        return bounded_printf(buf, size, "%.*f", decimals, value);
+
+    const bool negative = signbit(value);
+    if (negative)
+        value = -value;
+
+    const unsigned long long scaled = fixed_point(value, decimals);
+    const unsigned long long scale = powers_of_ten[decimals];
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *start = reverse_digits(end, scaled / scale);
+    const char *point = decimal_point();
+    const size_t point_len = strlen(point);
+
+    /* printf truncates what does not fit, which is rare enough to leave to
+     * it. */
+    const size_t len = (negative ? 1 : 0) + (end - start) + (decimals > 0 ? point_len + decimals : 0);
+    if (len >= size)
+        return bounded_printf(buf, size, "%.*f", decimals, negative ? -value : value);
+
+    char *walk = buf;
+    if (negative)
+        *(walk++) = '-';
+    memcpy(walk, start, end - start);
+    walk += end - start;
+
+    if (decimals > 0) {
+        memcpy(walk, point, point_len);
+        walk += point_len;
+
+        unsigned long long fraction = scaled % scale;
+        for (int i = decimals - 1; i >= 0; i--) {
+            walk[i] = '0' + (fraction % 10);
+            fraction /= 10;
+        }
+        walk += decimals;
+    }
+    *walk = '\0';
+    return walk - buf;
+}
+
+/*
+ * Formats a floating point value like printf("%g"): six significant digits
+ * without trailing zeros, into a buffer of the given size. Returns the number
+ * of bytes written, not counting the terminating NUL byte.
+ *
+ */
+int format_general(char *buf, size_t size, double value) {
+    const int precision = 6;
+    const double magnitude = fabs(value);
+    if (magnitude == 0)
+        return format_fixed(buf, size, value, 0);
+    if (!isfinite(value) || magnitude < 1e-4 || magnitude >= 1e6)
+        return bounded_printf(buf, size, "%g", value);
+
+    /* The decimal exponent decides how many digits are left for the
+     * fraction. Rounding might carry into another digit (999999.5). */
+    int exponent = floor(log10(magnitude));
+    if (fixed_point(magnitude, precision - 1 - exponent) >= (long long)powers_of_ten[precision])
+        exponent++;
+    if (exponent >= precision)
+        return bounded_printf(buf, size, "%g", value);
+
+    int len = format_fixed(buf, size, value, precision - 1 - exponent);
+    const char *point = decimal_point();
+    char *fraction = strstr(buf, point);
+    if (fraction != NULL) {
+        /* Strip trailing zeros and the decimal point if nothing is left. */
+        char *end = buf + len;
+        while (end[-1] == '0')
+            end--;
+        if (end == fraction + strlen(point))
+            end = fraction;
+        *end = '\0';
+        len = end - buf;
+    }
+    return len;
+}
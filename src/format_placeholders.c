@@ -68,3 +68,17 @@ char *format_placeholders(const char *format, placeholder_t *placeholders, int n
     *outwalk = '\0';
     return sstrdup(buffer);
 }
+
+/*
+ * Returns whether any of the given formats (which may be NULL) references the
+ * placeholder, so that modules can skip collecting data which is not
+ * displayed.
+ *
+ */
+bool formats_use_placeholder(const char *placeholder, const char *const *formats, int num) {
+    for (int i = 0; i < num; i++) {
+        if (formats[i] != NULL && strstr(formats[i], placeholder) != NULL)
+            return true;
+    }
+    return false;
+}
@@ -89,6 +89,12 @@ void *scalloc(size_t size) {
     return result;
 }
 
+void *srealloc(void *ptr, size_t size) {
+    void *result = realloc(ptr, size);
+    exit_if_null(result, "Error: out of memory (realloc(%zu))\n", size);
+    return result;
+}
+
 /*
  * Skip the given character for exactly 'amount' times, returns
  * a pointer to the first non-'character' character in 'input'.
@@ -106,6 +112,24 @@ char *skip_character(char *input, char character, int amount) {
     return (walk == input ? walk : walk - 1);
 }
 
+/*
+ * Returns the color for a value which is compared against the given
+ * thresholds (either may be NULL): "color_bad" from threshold_critical on,
+ * "color_degraded" from threshold_degraded on, NULL otherwise. When
+ * threshold_critical is below threshold_degraded, lower values are worse.
+ *
+ */
+const char *threshold_color(double value, const char *threshold_degraded, const char *threshold_critical) {
+    const double degraded = (threshold_degraded != NULL ? strtod(threshold_degraded, NULL) : 0);
+    const double critical = (threshold_critical != NULL ? strtod(threshold_critical, NULL) : 0);
+    const bool descending = (threshold_degraded != NULL && threshold_critical != NULL && critical < degraded);
+    if (threshold_critical != NULL && (descending ? value <= critical : value >= critical))
+        return "color_bad";
+    if (threshold_degraded != NULL && (descending ? value <= degraded : value >= degraded))
+        return "color_degraded";
+    return NULL;
+}
+
 /*
  * Write errormessage to statusbar and exit
  *
@@ -1,14 +1,18 @@
 // vim:ts=4:sw=4:expandtab
 #include <config.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <sys/ioctl.h>
 #include <dirent.h>
 #include <ctype.h>
+#include <wchar.h>
 
 #include "i3status.h"
 
@@ -68,8 +72,11 @@ void print_separator(const char *separator) {
         printf("<fc=%s>%s</fc>", cfg_getstr(cfg_general, "color_separator"), separator);
     else if (output_format == O_LEMONBAR)
         printf("%%{F%s}%s%%{F-}", cfg_getstr(cfg_general, "color_separator"), separator);
-    else if (output_format == O_TERM)
-        printf("%s%s%s", color("color_separator"), separator, endcolor());
+    else if (output_format == O_TERM) {
+        char buf[strlen(separator) + 64];
+        snprintf(buf, sizeof(buf), "%s%s%s", color("color_separator"), separator, endcolor());
+        term_output(buf);
+    }
     else if (output_format == O_NONE)
         printf("%s", separator);
 }
@@ -81,9 +88,246 @@ void reset_cursor(void) {
     printf("\033[?25h");
 }
 
+/* One block of the term output line: the separator in front of it and the
+ * text of the module. */
+typedef struct {
+    char *text;
+    size_t len;
+    size_t size;
+    int column;
+    int width;
+} term_block_t;
+
+/* The line currently being built and the line on screen. */
+static term_block_t *term_blocks = NULL;
+static term_block_t *term_shown = NULL;
+static int term_capacity = 0;
+static int term_count = 0;
+static int term_shown_count = -1;
+/* Set from the SIGWINCH handler. */
+static volatile sig_atomic_t term_redraw_needed = true;
+/* The width of the terminal, or 0 if it is unknown. */
+static int term_columns = -1;
+
+/*
+ * Returns the number of columns the given text occupies on the terminal,
+ * skipping the color escape sequences.
+ *
+ */
+static int term_text_width(const char *text) {
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    const char *walk = text;
+    const char *end = text + strlen(text);
+    int width = 0;
+    while (walk < end) {
+        if (*walk == '\033') {
+            /* Control sequence: ESC [ parameters final-byte */
+            walk++;
+            if (*walk == '[') {
+                walk++;
+                while (*walk != '\0' && (*walk < 0x40 || *walk > 0x7e))
+                    walk++;
+                if (*walk != '\0')
+                    walk++;
+            }
+            continue;
+        }
+        wchar_t wc;
+        size_t len = mbrtowc(&wc, walk, end - walk, &state);
+        if (len == (size_t)-1 || len == (size_t)-2) {
+            /* Invalid or truncated sequence, the terminal will most likely
+             * show a replacement character. */
+            memset(&state, 0, sizeof(state));
+            len = 1;
+            width++;
+        } else {
+            int w = wcwidth(wc);
+            if (w > 0)
+                width += w;
+        }
+        walk += len;
+    }
+    return width;
+}
+
+/*
+ * Starts the block with the given index of the term output line. Everything
+ * passed to term_output() until the next block is started belongs to it.
+ *
+ */
+void term_start_block(int index) {
+    if (index >= term_capacity) {
+        int capacity = index + 1;
+        term_blocks = srealloc(term_blocks, capacity * sizeof(term_block_t));
+        term_shown = srealloc(term_shown, capacity * sizeof(term_block_t));
+        memset(term_blocks + term_capacity, 0, (capacity - term_capacity) * sizeof(term_block_t));
+        memset(term_shown + term_capacity, 0, (capacity - term_capacity) * sizeof(term_block_t));
+        term_capacity = capacity;
+    }
+    term_block_t *block = &term_blocks[index];
+    if (block->text == NULL) {
+        block->size = 1;
+        block->text = scalloc(block->size);
+    }
+    block->text[0] = '\0';
+    block->len = 0;
+    term_count = index + 1;
+}
+
+/*
+ * Appends text to the current block of the term output line.
+ *
+ */
+void term_output(const char *text) {
+    if (term_count == 0)
+        term_start_block(0);
+    term_block_t *block = &term_blocks[term_count - 1];
+    size_t len = strlen(text);
+    if (block->len + len + 1 > block->size) {
+        block->size = block->len + len + 1;
+        block->text = srealloc(block->text, block->size);
+    }
+    memcpy(block->text + block->len, text, len + 1);
+    block->len += len;
+}
+
+/*
+ * Redraws the whole term output line on the next flush, e.g. when the
+ * terminal was resized.
+ *
+ */
+void term_force_redraw(void) {
+    term_redraw_needed = true;
+}
+
+/*
+ * Returns the width of the terminal, or 0 if stdout is not a terminal.
+ *
+ */
+static int terminal_columns(void) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == -1)
+        return 0;
+    return size.ws_col;
+}
+
+/*
+ * Brings the term output line on screen up to date. Blocks which kept their
+ * width are rewritten in place using cursor addressing, and only if their
+ * text changed. When any block changed its width, or the line does not fit
+ * into the terminal (so that it wraps and the cursor cannot be moved to the
+ * blocks), the line is redrawn.
+ *
+ */
+void term_flush_line(void) {
+    /* A resize during the flush leaves the flag set for the next one. */
+    const bool redraw_requested = term_redraw_needed;
+    term_redraw_needed = false;
+    if (redraw_requested || term_columns < 0)
+        term_columns = terminal_columns();
+
+    bool redraw = redraw_requested || term_count != term_shown_count;
+    int column = 0;
+    for (int i = 0; i < term_count; i++) {
+        term_block_t *block = &term_blocks[i];
+        block->column = column;
+        block->width = term_text_width(block->text);
+        column += block->width;
+        if (!redraw && block->width != term_shown[i].width)
+            redraw = true;
+    }
+    if (term_columns > 0 && column >= term_columns)
+        redraw = true;
+
+    if (redraw) {
+        /* Restore the cursor-position, clear line */
+        printf("\033[u\033[K");
+        for (int i = 0; i < term_count; i++)
+            fputs(term_blocks[i].text, stdout);
+        printf("\n");
+    } else {
+        bool changed = false;
+        for (int i = 0; i < term_count; i++) {
+            term_block_t *block = &term_blocks[i];
+            if (strcmp(block->text, term_shown[i].text) == 0)
+                continue;
+            printf("\033[u");
+            if (block->column > 0)
+                printf("\033[%dC", block->column);
+            fputs(block->text, stdout);
+            changed = true;
+        }
+        if (changed)
+            printf("\n");
+    }
+
+    term_block_t *swap = term_shown;
+    term_shown = term_blocks;
+    term_blocks = swap;
+    term_shown_count = term_count;
+    term_count = 0;
+}
+
+#define ONES UINT64_C(0x0101010101010101)
+#define HIGHS UINT64_C(0x8080808080808080)
+/* Non-zero if any byte of the word is below n (n <= 128), see
+ * https://graphics.stanford.edu/~seander/bithacks.html#HasLessInWord */
+#define HAS_BYTE_BELOW(word, n) (((word) - ONES * (n)) & ~(word) & HIGHS)
+/* Non-zero if any byte of the word equals c. */
+#define HAS_BYTE(word, c) HAS_BYTE_BELOW((word) ^ (ONES * (unsigned char)(c)), 1)
+
+/*
+ * Returns whether the given character has to be escaped in Pango markup.
+ *
+ */
+static bool needs_markup_escape(char c) {
+    switch (c) {
+        case '&':
+        case '<':
+        case '>':
+        case '\'':
+        case '"':
+            return true;
+        default:
+            return (0x1 <= c && c <= 0x8) ||
+                   (0xb <= c && c <= 0xc) ||
+                   (0xe <= c && c <= 0x1f);
+    }
+}
+
+/*
+ * Returns the length of the prefix of text which can be copied verbatim. The
+ * text is checked eight bytes at a time; only words which contain a special
+ * or control character are looked at byte by byte.
+ *
+ */
+static size_t markup_clean_length(const char *text, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (len - i >= sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, text + i, sizeof(word));
+            if (!(HAS_BYTE_BELOW(word, 0x20) ||
+                  HAS_BYTE(word, '&') || HAS_BYTE(word, '<') || HAS_BYTE(word, '>') ||
+                  HAS_BYTE(word, '\'') || HAS_BYTE(word, '"'))) {
+                i += sizeof(word);
+                continue;
+            }
+        }
+        const size_t stop = (len - i >= sizeof(uint64_t) ? i + sizeof(uint64_t) : len);
+        for (; i < stop; i++) {
+            if (needs_markup_escape(text[i]))
+                return i;
+        }
+    }
+    return len;
+}
+
 /*
  * Escapes ampersand, less-than, greater-than, single-quote, and double-quote
  * characters with the corresponding Pango markup strings if markup is enabled.
+ * Runs of characters which need no escaping are copied as a whole.
  * See the glib implementation:
  * https://git.gnome.org/browse/glib/tree/glib/gmarkup.c?id=03db1f455b4265654e237d2ad55464b4113cba8a#n2142
  *
@@ -96,10 +340,18 @@ void maybe_escape_markup(char *text, char *buffer, size_t size) {
         return;
     }
 
-    for (size_t i = 0; *text != '\0'; text++) {
-        if (i >= size) {
-            return;
-        }
+    const char *end = text + strlen(text);
+    size_t i = 0;
+    while (text < end && i < size) {
+        size_t clean = markup_clean_length(text, end - text);
+        if (clean > size - i)
+            clean = size - i;
+        memcpy(&buffer[i], text, clean);
+        i += clean;
+        text += clean;
+        if (text == end || i >= size)
+            break;
+
         switch (*text) {
             case '&':
                 i += snprintf(&buffer[i], size - i, "%s", "&amp;");
@@ -117,17 +369,12 @@ void maybe_escape_markup(char *text, char *buffer, size_t size) {
                 i += snprintf(&buffer[i], size - i, "%s", "&quot;");
                 break;
             default:
-                if ((0x1 <= *text && *text <= 0x8) ||
-                    (0xb <= *text && *text <= 0xc) ||
-                    (0xe <= *text && *text <= 0x1f)) {
-                    i += snprintf(&buffer[i], size - i, "&#x%x;", *text);
-                } else {
-                    buffer[i] = *text;
-                    i++;
-                }
+                i += snprintf(&buffer[i], size - i, "&#x%x;", *text);
                 break;
         }
+        text++;
     }
+    buffer[i < size ? i : size] = '\0';
 }
 
 /*
@@ -143,75 +143,140 @@ static void add_battery_info(struct battery_info *acc, const struct battery_info
 }
 #endif
 
-static bool slurp_battery_info(battery_info_ctx_t *ctx, struct battery_info *batt_info, yajl_gen json_gen, char *buffer, int number, const char *path, const char *format_down) {
-    char *outwalk = buffer;
-
 #if defined(__linux__)
-    char buf[1024];
-    const char *walk, *last;
-    bool watt_as_unit = false;
-    int voltage = -1;
-    char batpath[512];
-    sprintf(batpath, path, number);
-    INSTANCE(batpath);
+/* The uevent properties of a power supply which are used, without their
+ * POWER_SUPPLY_ prefix. uevent_names is sorted, so that a property can be
+ * looked up with bsearch(). */
+typedef enum {
+    UEVENT_CAPACITY,
+    UEVENT_CHARGE_FULL,
+    UEVENT_CHARGE_FULL_DESIGN,
+    UEVENT_CHARGE_NOW,
+    UEVENT_CURRENT_NOW,
+    UEVENT_ENERGY_FULL,
+    UEVENT_ENERGY_FULL_DESIGN,
+    UEVENT_ENERGY_NOW,
+    UEVENT_POWER_NOW,
+    UEVENT_STATUS,
+    UEVENT_TIME_TO_EMPTY_NOW,
+    UEVENT_VOLTAGE_NOW,
+    UEVENT_PROPERTIES,
+} uevent_property_t;
+
+static const char *const uevent_names[UEVENT_PROPERTIES] = {
+    [UEVENT_CAPACITY] = "CAPACITY",
+    [UEVENT_CHARGE_FULL] = "CHARGE_FULL",
+    [UEVENT_CHARGE_FULL_DESIGN] = "CHARGE_FULL_DESIGN",
+    [UEVENT_CHARGE_NOW] = "CHARGE_NOW",
+    [UEVENT_CURRENT_NOW] = "CURRENT_NOW",
+    [UEVENT_ENERGY_FULL] = "ENERGY_FULL",
+    [UEVENT_ENERGY_FULL_DESIGN] = "ENERGY_FULL_DESIGN",
+    [UEVENT_ENERGY_NOW] = "ENERGY_NOW",
+    [UEVENT_POWER_NOW] = "POWER_NOW",
+    [UEVENT_STATUS] = "STATUS",
+    [UEVENT_TIME_TO_EMPTY_NOW] = "TIME_TO_EMPTY_NOW",
+    [UEVENT_VOLTAGE_NOW] = "VOLTAGE_NOW",
+};
 
-    if (!slurp(batpath, buf, sizeof(buf))) {
-        OUTPUT_FULL_TEXT(format_down);
-        return false;
-    }
+static const struct {
+    const char *value;
+    charging_status_t status;
+} uevent_statuses[] = {
+    {"Charging", CS_CHARGING},
+    {"Full", CS_FULL},
+    {"Discharging", CS_DISCHARGING},
+    {"Not charging", CS_IDLE},
+};
 
-    for (walk = buf, last = buf; (walk - buf) < 1024; walk++) {
-        // `*walk` (slice of `buf`) is only initialised until `null` written by `slurp()`
-        if (*walk == '\0') {
-            break;
-        }
+/* A property name which is not terminated by a 0 byte, but by the '='. */
+typedef struct {
+    const char *name;
+    size_t len;
+} uevent_key_t;
+
+static int compare_uevent_name(const void *key, const void *name) {
+    const uevent_key_t *k = key;
+    const char *n = *(const char *const *)name;
+    int result = strncmp(k->name, n, k->len);
+    if (result == 0 && n[k->len] != '\0')
+        return -1;
+    return result;
+}
 
-        if (*walk == '\n') {
-            last = walk + 1;
+/*
+ * Parses the uevent file of a power supply into batt_info. Every line is
+ * looked up once in uevent_names instead of being compared to every
+ * property.
+ *
+ */
+static void parse_battery_uevent(const char *buf, struct battery_info *batt_info) {
+    bool watt_as_unit = false;
+    int voltage = -1;
+
+    for (const char *line = buf, *next; *line != '\0'; line = (*next == '\n' ? next + 1 : next)) {
+        next = strchrnul(line, '\n');
+        if (!BEGINS_WITH(line, "POWER_SUPPLY_"))
             continue;
-        }
+        uevent_key_t key = {.name = line + strlen("POWER_SUPPLY_")};
+        const char *value = memchr(key.name, '=', next - key.name);
+        if (value == NULL)
+            continue;
+        key.len = value - key.name;
+        value++;
 
-        if (*walk != '=')
+        const char *const *name = bsearch(&key, uevent_names, UEVENT_PROPERTIES, sizeof(*uevent_names), compare_uevent_name);
+        if (name == NULL)
             continue;
 
-        if (BEGINS_WITH(last, "POWER_SUPPLY_ENERGY_NOW=")) {
-            watt_as_unit = true;
-            batt_info->remaining = atoi(walk + 1);
-            batt_info->percentage_remaining = -1;
-        } else if (BEGINS_WITH(last, "POWER_SUPPLY_CHARGE_NOW=")) {
-            watt_as_unit = false;
-            batt_info->remaining = atoi(walk + 1);
-            batt_info->percentage_remaining = -1;
-        } else if (BEGINS_WITH(last, "POWER_SUPPLY_CAPACITY=") && batt_info->remaining == -1) {
-            batt_info->percentage_remaining = atoi(walk + 1);
-        } else if (BEGINS_WITH(last, "POWER_SUPPLY_CURRENT_NOW="))
-            batt_info->present_rate = abs(atoi(walk + 1));
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_VOLTAGE_NOW="))
-            voltage = abs(atoi(walk + 1));
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_TIME_TO_EMPTY_NOW="))
-            batt_info->seconds_remaining = abs(atoi(walk + 1)) * 60;
-        /* on some systems POWER_SUPPLY_POWER_NOW does not exist, but actually
-         * it is the same as POWER_SUPPLY_CURRENT_NOW but with μWh as
-         * unit instead of μAh. We will calculate it as we need it
-         * later. */
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_POWER_NOW="))
-            batt_info->present_rate = abs(atoi(walk + 1));
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Charging"))
-            batt_info->status = CS_CHARGING;
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Full"))
-            batt_info->status = CS_FULL;
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Discharging"))
-            batt_info->status = CS_DISCHARGING;
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS=Not charging"))
-            batt_info->status = CS_IDLE;
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_STATUS="))
-            batt_info->status = CS_UNKNOWN;
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_CHARGE_FULL_DESIGN=") ||
-                 BEGINS_WITH(last, "POWER_SUPPLY_ENERGY_FULL_DESIGN="))
-            batt_info->full_design = atoi(walk + 1);
-        else if (BEGINS_WITH(last, "POWER_SUPPLY_ENERGY_FULL=") ||
-                 BEGINS_WITH(last, "POWER_SUPPLY_CHARGE_FULL="))
-            batt_info->full_last = atoi(walk + 1);
+        switch ((uevent_property_t)(name - uevent_names)) {
+            case UEVENT_ENERGY_NOW:
+                watt_as_unit = true;
+                batt_info->remaining = atoi(value);
+                batt_info->percentage_remaining = -1;
+                break;
+            case UEVENT_CHARGE_NOW:
+                watt_as_unit = false;
+                batt_info->remaining = atoi(value);
+                batt_info->percentage_remaining = -1;
+                break;
+            case UEVENT_CAPACITY:
+                if (batt_info->remaining == -1)
+                    batt_info->percentage_remaining = atoi(value);
+                break;
+            /* on some systems POWER_SUPPLY_POWER_NOW does not exist, but actually
+             * it is the same as POWER_SUPPLY_CURRENT_NOW but with μWh as
+             * unit instead of μAh. We will calculate it as we need it
+             * later. */
+            case UEVENT_CURRENT_NOW:
+            case UEVENT_POWER_NOW:
+                batt_info->present_rate = abs(atoi(value));
+                break;
+            case UEVENT_VOLTAGE_NOW:
+                voltage = abs(atoi(value));
+                break;
+            case UEVENT_TIME_TO_EMPTY_NOW:
+                batt_info->seconds_remaining = abs(atoi(value)) * 60;
+                break;
+            case UEVENT_STATUS:
+                batt_info->status = CS_UNKNOWN;
+                for (size_t i = 0; i < sizeof(uevent_statuses) / sizeof(*uevent_statuses); i++) {
+                    if (BEGINS_WITH(value, uevent_statuses[i].value)) {
+                        batt_info->status = uevent_statuses[i].status;
+                        break;
+                    }
+                }
+                break;
+            case UEVENT_CHARGE_FULL_DESIGN:
+            case UEVENT_ENERGY_FULL_DESIGN:
+                batt_info->full_design = atoi(value);
+                break;
+            case UEVENT_CHARGE_FULL:
+            case UEVENT_ENERGY_FULL:
+                batt_info->full_last = atoi(value);
+                break;
+            case UEVENT_PROPERTIES:
+                break;
+        }
     }
 
     /* the difference between POWER_SUPPLY_ENERGY_NOW and
@@ -232,6 +297,95 @@ static bool slurp_battery_info(battery_info_ctx_t *ctx, struct battery_info *bat
             batt_info->full_last = (((float)voltage / 1000.0) * ((float)batt_info->full_last / 1000.0));
         }
     }
+}
+#endif
+
+#if defined(__linux__)
+/* How long the contents of a uevent file are used, in seconds, while the
+ * kernel notifies about power supply changes. */
+#define BATTERY_POLL_INTERVAL 120
+
+/* The size of the uevent file of a power supply which is read. */
+#define UEVENT_SIZE 1024
+
+/* Whether the kernel notifies about power supply changes, and how many
+ * there were. */
+static bool uevents_available = false;
+static uevent_counts_t power_supply_events;
+
+typedef struct {
+    char *path;
+    char contents[UEVENT_SIZE];
+    time_t read;
+    unsigned int changes;
+} uevent_file_t;
+
+static uevent_file_t *uevent_files = NULL;
+static int num_uevent_files = 0;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+/*
+ * Reads the uevent file of a power supply. While uevents are received, the
+ * contents are kept until the next power supply event, but at most for
+ * BATTERY_POLL_INTERVAL seconds.
+ *
+ */
+static bool read_uevent_file(const char *path, char *buf) {
+    if (!uevents_available)
+        return slurp_cached(path, buf, UEVENT_SIZE);
+
+    uevent_file_t *file = NULL;
+    for (int i = 0; i < num_uevent_files; i++) {
+        if (strcmp(uevent_files[i].path, path) == 0) {
+            file = &uevent_files[i];
+            break;
+        }
+    }
+    const time_t now = monotonic_seconds();
+    if (file != NULL && file->changes == power_supply_events.changes && now - file->read < BATTERY_POLL_INTERVAL) {
+        strcpy(buf, file->contents);
+        return true;
+    }
+
+    if (!slurp_cached(path, buf, UEVENT_SIZE)) {
+        if (file != NULL) {
+            free(file->path);
+            *file = uevent_files[--num_uevent_files];
+        }
+        return false;
+    }
+    if (file == NULL) {
+        uevent_files = srealloc(uevent_files, (num_uevent_files + 1) * sizeof(uevent_file_t));
+        file = &uevent_files[num_uevent_files++];
+        file->path = sstrdup(path);
+    }
+    strcpy(file->contents, buf);
+    file->read = now;
+    file->changes = power_supply_events.changes;
+    return true;
+}
+#endif
+
+static bool slurp_battery_info(battery_info_ctx_t *ctx, struct battery_info *batt_info, yajl_gen json_gen, char *buffer, int number, const char *path, const char *format_down) {
+    char *outwalk = buffer;
+
+#if defined(__linux__)
+    char buf[UEVENT_SIZE];
+    char batpath[512];
+    sprintf(batpath, path, number);
+    INSTANCE(batpath);
+
+    if (!read_uevent_file(batpath, buf)) {
+        OUTPUT_FULL_TEXT(format_down);
+        return false;
+    }
+
+    parse_battery_uevent(buf, batt_info);
 #elif defined(__DragonFly__)
     union acpi_battery_ioctl_arg battio;
     if (acpi_init()) {
@@ -527,6 +681,104 @@ static bool slurp_battery_info(battery_info_ctx_t *ctx, struct battery_info *bat
     return true;
 }
 
+#if defined(__linux__)
+/* How often "battery all" looks for new batteries, in seconds, when there
+ * are no uevents which announce them. */
+#define BATTERY_RESCAN_INTERVAL 30
+
+/* The uevent files matching the path of a "battery all" section, so that
+ * sysfs does not have to be searched on every tick. */
+typedef struct {
+    char *path;
+    glob_t globbuf;
+    bool globbed;
+    time_t scanned;
+    unsigned int hotplugs;
+} battery_list_t;
+
+static battery_list_t *battery_lists = NULL;
+static int num_battery_lists = 0;
+
+/*
+ * Searches for the uevent files matching the path again.
+ *
+ */
+static void scan_battery_list(battery_list_t *list) {
+    char *placeholder;
+    char *globpath = sstrdup(list->path);
+    if ((placeholder = strstr(list->path, "%d")) != NULL) {
+        char *globplaceholder = globpath + (placeholder - list->path);
+        *globplaceholder = '*';
+        strcpy(globplaceholder + 1, placeholder + 2);
+    }
+
+    if (list->globbed)
+        globfree(&list->globbuf);
+    list->globbed = (glob(globpath, 0, NULL, &list->globbuf) == 0);
+    list->scanned = monotonic_seconds();
+    list->hotplugs = power_supply_events.hotplugs;
+    free(globpath);
+}
+
+/*
+ * Returns the batteries matching the given path. The list is searched for
+ * again when a power supply is added or removed, or, without uevents, every
+ * BATTERY_RESCAN_INTERVAL seconds.
+ *
+ */
+static battery_list_t *battery_list(const char *path, bool *rescanned) {
+    battery_list_t *list = NULL;
+    for (int i = 0; i < num_battery_lists; i++) {
+        if (strcmp(battery_lists[i].path, path) == 0) {
+            list = &battery_lists[i];
+            break;
+        }
+    }
+    if (list == NULL) {
+        battery_lists = srealloc(battery_lists, (num_battery_lists + 1) * sizeof(battery_list_t));
+        list = &battery_lists[num_battery_lists++];
+        *list = (battery_list_t){.path = sstrdup(path), .globbed = false};
+        scan_battery_list(list);
+        *rescanned = true;
+    } else if ((uevents_available && list->hotplugs != power_supply_events.hotplugs) ||
+               (!uevents_available && monotonic_seconds() - list->scanned >= BATTERY_RESCAN_INTERVAL)) {
+        scan_battery_list(list);
+        *rescanned = true;
+    } else {
+        *rescanned = false;
+    }
+    return list;
+}
+
+/*
+ * Adds all batteries of the list to batt_info. Returns the path of the
+ * first battery which cannot be read (e.g. because it has been unplugged
+ * since the list was searched), or NULL on success.
+ *
+ */
+static const char *add_listed_batteries(const battery_list_t *list, struct battery_info *batt_info, bool *is_found) {
+    char buf[UEVENT_SIZE];
+    *is_found = false;
+    for (size_t i = 0; list->globbed && i < list->globbuf.gl_pathc; i++) {
+        /* Probe to see if there is such a battery. */
+        struct battery_info batt_buf = {
+            .full_design = 0,
+            .full_last = 0,
+            .remaining = 0,
+            .present_rate = 0,
+            .status = CS_UNKNOWN,
+        };
+        if (!read_uevent_file(list->globbuf.gl_pathv[i], buf))
+            return list->globbuf.gl_pathv[i];
+
+        parse_battery_uevent(buf, &batt_buf);
+        *is_found = true;
+        add_battery_info(batt_info, &batt_buf);
+    }
+    return NULL;
+}
+#endif
+
 /*
  * Populate batt_info with aggregate information about all batteries.
  * Returns false on error, and an error message will have been written.
@@ -534,44 +786,30 @@ static bool slurp_battery_info(battery_info_ctx_t *ctx, struct battery_info *bat
 static bool slurp_all_batteries(battery_info_ctx_t *ctx, struct battery_info *batt_info, yajl_gen json_gen, char *buffer, const char *path, const char *format_down) {
 #if defined(__linux__)
     char *outwalk = buffer;
-    bool is_found = false;
+    bool is_found;
 
-    char *placeholder;
-    char *globpath = sstrdup(path);
-    if ((placeholder = strstr(path, "%d")) != NULL) {
-        char *globplaceholder = globpath + (placeholder - path);
-        *globplaceholder = '*';
-        strcpy(globplaceholder + 1, placeholder + 2);
-    }
-
-    if (!strcmp(globpath, path)) {
+    if (strstr(path, "%d") == NULL) {
         OUTPUT_FULL_TEXT("no '%d' in battery path");
         return false;
     }
 
-    glob_t globbuf;
-    if (glob(globpath, 0, NULL, &globbuf) == 0) {
-        for (size_t i = 0; i < globbuf.gl_pathc; i++) {
-            /* Probe to see if there is such a battery. */
-            struct battery_info batt_buf = {
-                .full_design = 0,
-                .full_last = 0,
-                .remaining = 0,
-                .present_rate = 0,
-                .status = CS_UNKNOWN,
-            };
-            if (!slurp_battery_info(ctx, &batt_buf, json_gen, buffer, i, globbuf.gl_pathv[i], format_down)) {
-                globfree(&globbuf);
-                free(globpath);
-                return false;
-            }
-
-            is_found = true;
-            add_battery_info(batt_info, &batt_buf);
-        }
-        globfree(&globbuf);
+    bool rescanned;
+    battery_list_t *list = battery_list(path, &rescanned);
+    const struct battery_info empty = *batt_info;
+    const char *failed = add_listed_batteries(list, batt_info, &is_found);
+    if (failed != NULL && !rescanned) {
+        /* A battery went away, so the list is outdated. */
+        scan_battery_list(list);
+        *batt_info = empty;
+        failed = add_listed_batteries(list, batt_info, &is_found);
     }
-    free(globpath);
+    if (failed != NULL) {
+        INSTANCE(failed);
+        OUTPUT_FULL_TEXT(format_down);
+        return false;
+    }
+    for (size_t i = 0; list->globbed && i < list->globbuf.gl_pathc; i++)
+        INSTANCE(list->globbuf.gl_pathv[i]);
 
     if (!is_found) {
         OUTPUT_FULL_TEXT(format_down);
@@ -589,6 +827,40 @@ static bool slurp_all_batteries(battery_info_ctx_t *ctx, struct battery_info *ba
     return true;
 }
 
+/*
+ * Formats a time of day or a duration as HH:MM or HH:MM:SS.
+ *
+ */
+static void format_clock(char *buf, int hours, int minutes, int seconds, bool hide_seconds) {
+    buf += format_int(buf, max(hours, 0), 2, '0');
+    *(buf++) = ':';
+    buf += format_int(buf, max(minutes, 0), 2, '0');
+    if (!hide_seconds) {
+        *(buf++) = ':';
+        format_int(buf, max(seconds, 0), 2, '0');
+    }
+}
+
+/*
+ * Formats the percentage according to format_percentage. The default
+ * "%.02f%s" and similar formats are handled without printf.
+ *
+ */
+static void format_battery_percentage(char *buf, const char *format_percentage, float percentage) {
+    const char *walk = format_percentage;
+    if (walk[0] == '%' && walk[1] == '.' && isdigit((unsigned char)walk[2])) {
+        char *end;
+        long decimals = strtol(walk + 2, &end, 10);
+        /* More decimals are left to snprintf, which bounds them. */
+        if (strcmp(end, "f%s") == 0 && decimals <= 9) {
+            buf += format_fixed(buf, STRING_SIZE - strlen(pct_mark), percentage, decimals);
+            stpcpy(buf, pct_mark);
+            return;
+        }
+    }
+    snprintf(buf, STRING_SIZE, format_percentage, percentage, pct_mark);
+}
+
 void print_battery_info(battery_info_ctx_t *ctx) {
     char *outwalk = ctx->buf;
     struct battery_info batt_info = {
@@ -613,6 +885,12 @@ void print_battery_info(battery_info_ctx_t *ctx) {
     ctx->hide_seconds = true;
 #endif
 
+#if defined(__linux__)
+    /* AC adapters are power supplies as well, so plugging in a charger
+     * updates the battery right away. */
+    uevents_available = uevents_watch("power_supply", &power_supply_events, true);
+#endif
+
     if (ctx->number < 0) {
         if (!slurp_all_batteries(ctx, &batt_info, ctx->json_gen, ctx->buf, ctx->path, ctx->format_down))
             return;
@@ -663,14 +941,33 @@ void print_battery_info(battery_info_ctx_t *ctx) {
 
     if (batt_info.status == CS_DISCHARGING && ctx->low_threshold > 0) {
         if (batt_info.percentage_remaining >= 0 && strcasecmp(ctx->threshold_type, "percentage") == 0 && batt_info.percentage_remaining < ctx->low_threshold) {
-            START_COLOR("color_bad");
             colorful_output = true;
         } else if (batt_info.seconds_remaining >= 0 && strcasecmp(ctx->threshold_type, "time") == 0 && batt_info.seconds_remaining < 60 * ctx->low_threshold) {
-            START_COLOR("color_bad");
             colorful_output = true;
         }
     }
 
+    /* The remaining and empty time are only displayed with minute precision
+     * when hide_seconds is set, and not at all when they are unknown. */
+    const int time_precision = ctx->hide_seconds ? 60 : 1;
+    int displayed_remaining = -1;
+    time_t displayed_emptytime = -1;
+    if (batt_info.seconds_remaining >= 0) {
+        displayed_remaining = batt_info.seconds_remaining / time_precision;
+        displayed_emptytime = (time(NULL) + batt_info.seconds_remaining) / time_precision;
+    }
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, batt_info.status);
+    FINGERPRINT(fingerprint, batt_info.percentage_remaining);
+    FINGERPRINT(fingerprint, displayed_remaining);
+    FINGERPRINT(fingerprint, displayed_emptytime);
+    FINGERPRINT(fingerprint, batt_info.present_rate);
+    FINGERPRINT(fingerprint, colorful_output);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
+    if (colorful_output)
+        START_COLOR("color_bad");
+
     char string_status[STRING_SIZE];
     char string_percentage[STRING_SIZE];
     // following variables are not alwasy set. If they are not set they should be empty.
@@ -696,7 +993,7 @@ void print_battery_info(battery_info_ctx_t *ctx) {
             statusstr = ctx->status_unk;
     }
     snprintf(string_status, STRING_SIZE, "%s", statusstr);
-    snprintf(string_percentage, STRING_SIZE, ctx->format_percentage, batt_info.percentage_remaining, pct_mark);
+    format_battery_percentage(string_percentage, ctx->format_percentage, batt_info.percentage_remaining);
 
     if (batt_info.seconds_remaining >= 0) {
         int seconds, hours, minutes;
@@ -704,24 +1001,20 @@ void print_battery_info(battery_info_ctx_t *ctx) {
         seconds = batt_info.seconds_remaining - (hours * 3600);
         minutes = seconds / 60;
         seconds -= (minutes * 60);
-        if (ctx->hide_seconds)
-            snprintf(string_remaining, STRING_SIZE, "%02d:%02d", max(hours, 0), max(minutes, 0));
-        else
-            snprintf(string_remaining, STRING_SIZE, "%02d:%02d:%02d", max(hours, 0), max(minutes, 0), max(seconds, 0));
+        format_clock(string_remaining, hours, minutes, seconds, ctx->hide_seconds);
     }
 
     if (batt_info.seconds_remaining >= 0) {
         time_t empty_time = time(NULL) + batt_info.seconds_remaining;
         set_timezone(NULL); /* Use local time. */
         struct tm *empty_tm = localtime(&empty_time);
-        if (ctx->hide_seconds)
-            snprintf(string_emptytime, STRING_SIZE, "%02d:%02d", max(empty_tm->tm_hour, 0), max(empty_tm->tm_min, 0));
-        else
-            snprintf(string_emptytime, STRING_SIZE, "%02d:%02d:%02d", max(empty_tm->tm_hour, 0), max(empty_tm->tm_min, 0), max(empty_tm->tm_sec, 0));
+        format_clock(string_emptytime, empty_tm->tm_hour, empty_tm->tm_min, empty_tm->tm_sec, ctx->hide_seconds);
     }
 
-    if (batt_info.present_rate >= 0)
-        snprintf(string_consumption, STRING_SIZE, "%1.2fW", batt_info.present_rate / 1e6);
+    if (batt_info.present_rate >= 0) {
+        char *walk = string_consumption + format_fixed(string_consumption, sizeof(string_consumption), batt_info.present_rate / 1e6, 2);
+        stpcpy(walk, "W");
+    }
 
     placeholder_t placeholders[] = {
         {.name = "%status", .value = string_status},
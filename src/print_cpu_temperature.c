@@ -5,6 +5,7 @@
 #include <glob.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <yajl/yajl_gen.h>
 #include <yajl/yajl_version.h>
 
@@ -50,6 +51,8 @@
 typedef struct temperature_s {
     double raw_value;
     char formatted_value[20];
+    /* Whether the sensor reported a plausible value. */
+    bool valid;
 } temperature_t;
 
 #define ERROR_CODE 1
@@ -59,16 +62,17 @@ static int read_temperature(char *thermal_zone, temperature_t *temperature) {
     static char buf[16];
     long int temp;
 
-    if (!slurp(thermal_zone, buf, sizeof(buf)))
+    if (!slurp_cached(thermal_zone, buf, sizeof(buf)))
         return ERROR_CODE;
 
     temp = strtol(buf, NULL, 10);
     temperature->raw_value = temp / 1000;
 
-    if (temp == LONG_MIN || temp == LONG_MAX || temp <= 0)
+    if (temp == LONG_MIN || temp == LONG_MAX || temp <= 0) {
         strcpy(temperature->formatted_value, "?");
-    else
-        sprintf(temperature->formatted_value, "%ld", (temp / 1000));
+        temperature->valid = false;
+    } else
+        format_int(temperature->formatted_value, temp / 1000, 0, ' ');
 
 #elif defined(__DragonFly__)
     struct sensor th_sensor;
@@ -82,7 +86,7 @@ static int read_temperature(char *thermal_zone, temperature_t *temperature) {
     }
 
     temperature->raw_value = MUKTOC(th_sensor.value);
-    sprintf(temperature->formatted_value, "%.2f", MUKTOC(th_sensor.value));
+    format_fixed(temperature->formatted_value, sizeof(temperature->formatted_value), MUKTOC(th_sensor.value), 2);
 
 #elif defined(__FreeBSD__) || defined(__FreeBSD_kernel__)
     int sysctl_rslt;
@@ -125,7 +129,7 @@ static int read_temperature(char *thermal_zone, temperature_t *temperature) {
                     }
                 }
                 temperature->raw_value = MUKTOC(sensor.value);
-                sprintf(temperature->formatted_value, "%.2f", MUKTOC(sensor.value));
+                format_fixed(temperature->formatted_value, sizeof(temperature->formatted_value), MUKTOC(sensor.value), 2);
             }
         }
     }
@@ -187,7 +191,7 @@ static int read_temperature(char *thermal_zone, temperature_t *temperature) {
 
             float temp = MUKTOC(prop_number_integer_value(obj3));
             temperature->raw_value = temp;
-            sprintf(temperature->formatted_value, "%.2f", temp);
+            format_fixed(temperature->formatted_value, sizeof(temperature->formatted_value), temp, 2);
 
             break;
         }
@@ -206,43 +210,209 @@ error_netbsd1:
     return 0;
 }
 
+/* How often the path is searched for sensors again, in seconds, when there
+ * are no uevents which announce new ones. */
+#define SENSOR_RESCAN_INTERVAL 30
+
+/* The sensors matching the path of a cpu_temperature section. The path is
+ * searched once instead of on every update. */
+typedef struct {
+    char *path;
+    glob_t globbuf;
+    /* The name of each sensor, e.g. "Core 0", for %hottest. */
+    char **labels;
+    time_t scanned;
+    unsigned int hotplugs;
+    /* Set when a sensor could not be read, e.g. because its driver was
+     * unloaded. */
+    bool stale;
+} sensor_set_t;
+
+static sensor_set_t *sensor_sets = NULL;
+static int num_sensor_sets = 0;
+
+/* Whether the kernel announces new hwmon devices and thermal zones, and how
+ * many there were. */
+static bool uevents_available = false;
+static uevent_counts_t sensor_events;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+/*
+ * Returns a name for the given sensor: the label of a hwmon input
+ * (tempN_label next to tempN_input), the type of a thermal zone or, if there
+ * is neither, the path of the sensor.
+ *
+ */
+static char *sensor_label(const char *sensor) {
+#if defined(__linux__)
+    char path[PATH_MAX];
+    char buf[64];
+    const char *suffix = strrchr(sensor, '_');
+    const char *slash = strrchr(sensor, '/');
+    if (suffix != NULL && strcmp(suffix, "_input") == 0)
+        snprintf(path, sizeof(path), "%.*s_label", (int)(suffix - sensor), sensor);
+    else if (slash != NULL)
+        snprintf(path, sizeof(path), "%.*s/type", (int)(slash - sensor), sensor);
+    else
+        return sstrdup(sensor);
+
+    if (slurp(path, buf, sizeof(buf))) {
+        char *label = trim(buf);
+        if (*label != '\0')
+            return label;
+        free(label);
+    }
+#endif
+    return sstrdup(sensor);
+}
+
+/*
+ * Searches for the sensors matching the path again. A path without
+ * wildcards is used as is.
+ *
+ */
+static void scan_sensor_set(sensor_set_t *set) {
+    if (set->labels != NULL) {
+        for (size_t i = 0; i < set->globbuf.gl_pathc; i++)
+            free(set->labels[i]);
+        free(set->labels);
+        globfree(&set->globbuf);
+    }
+
+    if (glob(set->path, GLOB_NOCHECK | GLOB_TILDE, NULL, &set->globbuf) != 0)
+        die("glob() failed\n");
+    set->labels = scalloc(set->globbuf.gl_pathc * sizeof(char *));
+    for (size_t i = 0; i < set->globbuf.gl_pathc; i++)
+        set->labels[i] = sensor_label(set->globbuf.gl_pathv[i]);
+
+    set->scanned = monotonic_seconds();
+    set->hotplugs = sensor_events.hotplugs;
+    set->stale = false;
+}
+
+/*
+ * Returns the sensors matching the given path. They are searched for again
+ * when a hwmon device or thermal zone is added or removed (or, without
+ * uevents, every SENSOR_RESCAN_INTERVAL seconds) and when one of them could
+ * not be read.
+ *
+ */
+static sensor_set_t *sensor_set(const char *path) {
+    for (int i = 0; i < num_sensor_sets; i++) {
+        sensor_set_t *set = &sensor_sets[i];
+        if (strcmp(set->path, path) != 0)
+            continue;
+        if (set->stale ||
+            (uevents_available && set->hotplugs != sensor_events.hotplugs) ||
+            (!uevents_available && monotonic_seconds() - set->scanned >= SENSOR_RESCAN_INTERVAL))
+            scan_sensor_set(set);
+        return set;
+    }
+
+    sensor_sets = srealloc(sensor_sets, (num_sensor_sets + 1) * sizeof(sensor_set_t));
+    sensor_set_t *set = &sensor_sets[num_sensor_sets++];
+    *set = (sensor_set_t){.path = sstrdup(path), .labels = NULL};
+    scan_sensor_set(set);
+    return set;
+}
+
+/*
+ * Formats an aggregated temperature like read_temperature() formats the
+ * temperature of a single sensor.
+ *
+ */
+static void format_temperature(char *buf, double value) {
+#if defined(__linux__)
+    format_int(buf, (long long)(value + 0.5), 0, ' ');
+#else
+    format_fixed(buf, STRING_SIZE, value, 2);
+#endif
+}
+
 /*
  * Reads the CPU temperature from /sys/class/thermal/thermal_zone%d/temp (or
  * the user provided path) and returns the temperature in degree celsius.
  *
+ * The path may match many sensors. %degrees is the temperature of the first
+ * one, %max, %avg and %hottest aggregate all of them.
+ *
  */
 void print_cpu_temperature_info(cpu_temperature_ctx_t *ctx) {
     char *outwalk = ctx->buf;
 #ifdef THERMAL_ZONE
     const char *selected_format = ctx->format;
     bool colorful_output = false;
-    char *thermal_zone;
-    temperature_t temperature;
-    temperature.raw_value = 0;
-    sprintf(temperature.formatted_value, "%.2f", 0.0);
 
+    uevents_available = uevents_watch("hwmon", &sensor_events, false);
+    uevents_watch("thermal", &sensor_events, false);
+
+    char path[PATH_MAX];
+    const char *placeholder;
     if (ctx->path == NULL)
-        asprintf(&thermal_zone, THERMAL_ZONE, ctx->zone);
-    else {
-        static glob_t globbuf;
-        if (glob(ctx->path, GLOB_NOCHECK | GLOB_TILDE, NULL, &globbuf) != 0)
-            die("glob() failed\n");
-        if (globbuf.gl_pathc == 0) {
-            /* No glob matches, the specified path does not contain a wildcard. */
-            asprintf(&thermal_zone, ctx->path, ctx->zone);
-        } else {
-            /* glob matched, we take the first match and ignore the others */
-            asprintf(&thermal_zone, "%s", globbuf.gl_pathv[0]);
+        snprintf(path, sizeof(path), THERMAL_ZONE, ctx->zone);
+    else if ((placeholder = strstr(ctx->path, "%d")) != NULL)
+        snprintf(path, sizeof(path), "%.*s%d%s", (int)(placeholder - ctx->path), ctx->path, ctx->zone, placeholder + 2);
+    else
+        snprintf(path, sizeof(path), "%s", ctx->path);
+
+    sensor_set_t *sensors = sensor_set(path);
+    INSTANCE(sensors->globbuf.gl_pathv[0]);
+
+    /* All sensors are read in one go, their files stay open. */
+    temperature_t degrees, hottest;
+    bool have_degrees = false;
+    int num_valid = 0;
+    size_t hottest_sensor = 0;
+    double sum = 0;
+    for (size_t i = 0; i < sensors->globbuf.gl_pathc; i++) {
+        temperature_t temperature = {.raw_value = 0, .valid = true};
+        if (read_temperature(sensors->globbuf.gl_pathv[i], &temperature) != 0) {
+            sensors->stale = true;
+            continue;
+        }
+        if (!have_degrees) {
+            degrees = temperature;
+            have_degrees = true;
         }
-        globfree(&globbuf);
+        if (!temperature.valid)
+            continue;
+        if (num_valid == 0 || temperature.raw_value > hottest.raw_value) {
+            hottest = temperature;
+            hottest_sensor = i;
+        }
+        sum += temperature.raw_value;
+        num_valid++;
     }
+    if (!have_degrees)
+        goto error;
 
-    INSTANCE(thermal_zone);
+    char string_max[STRING_SIZE], string_avg[STRING_SIZE];
+    const char *string_hottest;
+    if (num_valid > 0) {
+        snprintf(string_max, STRING_SIZE, "%s", hottest.formatted_value);
+        format_temperature(string_avg, sum / num_valid);
+        string_hottest = sensors->labels[hottest_sensor];
+    } else {
+        strcpy(string_max, "?");
+        strcpy(string_avg, "?");
+        string_hottest = "?";
+    }
 
-    if (read_temperature(thermal_zone, &temperature) != 0)
-        goto error;
+    const bool above = degrees.raw_value >= ctx->max_threshold;
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    fingerprint = fingerprint_str(fingerprint, degrees.formatted_value);
+    fingerprint = fingerprint_str(fingerprint, string_max);
+    fingerprint = fingerprint_str(fingerprint, string_avg);
+    fingerprint = fingerprint_str(fingerprint, string_hottest);
+    FINGERPRINT(fingerprint, above);
+    RETURN_IF_RENDER_CACHED(fingerprint);
 
-    if (temperature.raw_value >= ctx->max_threshold) {
+    if (above) {
         START_COLOR("color_bad");
         colorful_output = true;
         if (ctx->format_above_threshold != NULL)
@@ -250,9 +420,12 @@ void print_cpu_temperature_info(cpu_temperature_ctx_t *ctx) {
     }
 
     char string_degrees[STRING_SIZE];
-    snprintf(string_degrees, STRING_SIZE, "%s", temperature.formatted_value);
+    snprintf(string_degrees, STRING_SIZE, "%s", degrees.formatted_value);
     placeholder_t placeholders[] = {
-        {.name = "%degrees", .value = string_degrees}};
+        {.name = "%degrees", .value = string_degrees},
+        {.name = "%max", .value = string_max},
+        {.name = "%avg", .value = string_avg},
+        {.name = "%hottest", .value = string_hottest}};
 
     const size_t num = sizeof(placeholders) / sizeof(placeholder_t);
     char *formatted = format_placeholders(selected_format, &placeholders[0], num);
@@ -264,12 +437,9 @@ void print_cpu_temperature_info(cpu_temperature_ctx_t *ctx) {
         colorful_output = false;
     }
 
-    free(thermal_zone);
-
     OUTPUT_FULL_TEXT(ctx->buf);
     return;
 error:
-    free(thermal_zone);
 #endif
 
     OUTPUT_FULL_TEXT("can't read temp");
@@ -1,10 +1,9 @@
 // vim:ts=4:sw=4:expandtab
 #include <config.h>
-#if defined(__linux__)
-#include <sys/sysinfo.h>
-#endif
+#include <glob.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <yajl/yajl_gen.h>
@@ -58,11 +57,197 @@ struct cpu_usage {
 };
 
 #if defined(__linux__)
+#define TOP_CPUS 3
+
 static int cpu_count = 0;
-#endif
+static int *cpu_usages = NULL;
+
+/* The physical package (socket) and NUMA node of each CPU, -1 if unknown. */
+static int *cpu_sockets = NULL;
+static int *cpu_nodes = NULL;
+static int topology_size = 0;
+
+static const cpu_times_t no_times;
+
+/*
+ * Returns the difference between two samples of a counter. The counters of a
+ * CPU which was taken offline might start over.
+ *
+ */
+static unsigned long long counter_delta(unsigned long long curr, unsigned long long prev) {
+    return (curr > prev ? curr - prev : 0);
+}
+
+static int percentage(unsigned long long part, unsigned long long total) {
+    return (total ? (1000 * part / total + 5) / 10 : 0);
+}
+
+/*
+ * Returns the percentage of time in which the CPU was busy between two
+ * samples.
+ *
+ */
+static int usage_between(const cpu_times_t *prev, const cpu_times_t *curr) {
+    const unsigned long long total = counter_delta(cpu_times_total(curr), cpu_times_total(prev));
+    const unsigned long long idle = counter_delta(cpu_times_idle(curr), cpu_times_idle(prev));
+    return percentage(total > idle ? total - idle : 0, total);
+}
+
+/*
+ * Returns how often per second a counter was incremented between two
+ * snapshots.
+ *
+ */
+static long long rate_between(const proc_stat_t *prev, const proc_stat_t *curr, unsigned long long prev_count, unsigned long long curr_count) {
+    if (prev == NULL)
+        return 0;
+    const double seconds = (curr->time.tv_sec - prev->time.tv_sec) + (curr->time.tv_nsec - prev->time.tv_nsec) / 1e9;
+    if (seconds <= 0)
+        return 0;
+    return llround(counter_delta(curr_count, prev_count) / seconds);
+}
+
+/*
+ * Whether the CPU had a line in /proc/stat, i.e. was online.
+ *
+ */
+static bool cpu_online(const proc_stat_t *stat, int cpu) {
+    return cpu < stat->cpus_size && stat->online[cpu];
+}
+
+/*
+ * Whether CPUs went online or offline since the last call. The list of online
+ * CPUs in sysfs is a single small file which the fd cache keeps open, so
+ * polling it is cheap.
+ *
+ */
+static bool cpus_hotplugged(void) {
+    static char last_online[256] = "";
+    char online[256];
+    if (!slurp_cached("/sys/devices/system/cpu/online", online, sizeof(online)) ||
+        strcmp(online, last_online) == 0)
+        return false;
+    strcpy(last_online, online);
+    return true;
+}
+
+/*
+ * Reads which socket and NUMA node each CPU belongs to from sysfs. The
+ * topology directory of a CPU only exists while it is online, so this is
+ * read again whenever CPUs are hotplugged.
+ *
+ */
+static void read_topology(int num_cpus) {
+    cpu_sockets = srealloc(cpu_sockets, num_cpus * sizeof(int));
+    cpu_nodes = srealloc(cpu_nodes, num_cpus * sizeof(int));
+    for (int cpu = 0; cpu < num_cpus; cpu++) {
+        char path[128], buf[16];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        cpu_sockets[cpu] = (slurp(path, buf, sizeof(buf)) ? atoi(buf) : -1);
+        cpu_nodes[cpu] = -1;
+    }
+
+    glob_t globbuf;
+    if (glob("/sys/devices/system/node/node[0-9]*/cpulist", 0, NULL, &globbuf) == 0) {
+        for (size_t i = 0; i < globbuf.gl_pathc; i++) {
+            const int node = atoi(globbuf.gl_pathv[i] + strlen("/sys/devices/system/node/node"));
+            char list[4096];
+            if (!slurp(globbuf.gl_pathv[i], list, sizeof(list)))
+                continue;
+
+            /* The list consists of ranges like "0-3,8-11". */
+            for (char *walk = list; *walk >= '0' && *walk <= '9';) {
+                const long first = strtol(walk, &walk, 10);
+                long last = first;
+                if (*walk == '-')
+                    last = strtol(walk + 1, &walk, 10);
+                for (long cpu = first; cpu <= last && cpu < num_cpus; cpu++)
+                    cpu_nodes[cpu] = node;
+                if (*walk == ',')
+                    walk++;
+            }
+        }
+        globfree(&globbuf);
+    }
+    topology_size = num_cpus;
+}
+
+/*
+ * Returns the average usage of the online CPUs which belong to the given
+ * group (socket or NUMA node) or -1 if there are none.
+ *
+ */
+static int group_usage(const proc_stat_t *stat, const int *groups, int group) {
+    int sum = 0, count = 0;
+    for (int cpu = 0; cpu < cpu_count && cpu < topology_size; cpu++) {
+        if (groups[cpu] == group && cpu_online(stat, cpu)) {
+            sum += cpu_usages[cpu];
+            count++;
+        }
+    }
+    return (count ? (sum + count / 2) / count : -1);
+}
+
+/*
+ * Prints the TOP_CPUS busiest online CPUs as "<cpu>:<usage>", separated by
+ * spaces.
+ *
+ */
+static char *print_top_cpus(char *outwalk, const proc_stat_t *stat) {
+    const int count = TOP_CPUS;
+    int top[TOP_CPUS];
+    int found = 0;
+    for (int cpu = 0; cpu < cpu_count; cpu++) {
+        if (!cpu_online(stat, cpu))
+            continue;
+        int pos = (found < count ? found++ : count);
+        for (; pos > 0 && cpu_usages[top[pos - 1]] < cpu_usages[cpu]; pos--) {
+            if (pos < count)
+                top[pos] = top[pos - 1];
+        }
+        if (pos < count)
+            top[pos] = cpu;
+    }
+
+    for (int i = 0; i < found; i++) {
+        if (i > 0)
+            *(outwalk++) = ' ';
+        outwalk += format_int(outwalk, top[i], 0, ' ');
+        *(outwalk++) = ':';
+        outwalk += format_int(outwalk, cpu_usages[top[i]], 2, '0');
+        outwalk = stpcpy(outwalk, pct_mark);
+    }
+    return outwalk;
+}
+
+/*
+ * Prints the average usage of the socket or NUMA node given in the format,
+ * e.g. %socket0 or %node1, and returns the length of the placeholder.
+ *
+ */
+static int print_group_usage(char **outwalk, const char *placeholder, const char *name, const proc_stat_t *stat, const int *groups) {
+    const char *digits = placeholder + strlen(name);
+    if (*digits < '0' || *digits > '9') {
+        fprintf(stderr, "i3status: provided %s number cannot be parsed\n", name);
+        return strlen(name);
+    }
+
+    char *end;
+    const long number = strtol(digits, &end, 10);
+    const int usage = (number > INT_MAX ? -1 : group_usage(stat, groups, number));
+    if (usage == -1) {
+        fprintf(stderr, "i3status: provided %s number '%ld' has no online CPU\n", name, number);
+    } else {
+        *outwalk += format_int(*outwalk, usage, 2, '0');
+        *outwalk = stpcpy(*outwalk, pct_mark);
+    }
+    return end - placeholder;
+}
+#else
 static struct cpu_usage prev_all = {0, 0, 0, 0, 0};
-static struct cpu_usage *prev_cpus = NULL;
-static struct cpu_usage *curr_cpus = NULL;
+#endif
+
+#define USES_PLACEHOLDER(placeholder) FORMATS_USE((placeholder), ctx->format, ctx->format_above_threshold, ctx->format_above_degraded_threshold)
 
 /*
  * Reads the CPU utilization from /proc/stat and returns the usage as a
@@ -73,76 +258,72 @@ void print_cpu_usage(cpu_usage_ctx_t *ctx) {
     const char *selected_format = ctx->format;
     const char *walk;
     char *outwalk = ctx->buf;
-    struct cpu_usage curr_all = {0, 0, 0, 0, 0};
-#if defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
-    long diff_idle, diff_total;
-#else
-    int diff_idle, diff_total;
-#endif
     int diff_usage;
     bool colorful_output = false;
 
 #if defined(__linux__)
 
-    // Detecting if CPU count has changed
-    int curr_cpu_count = get_nprocs_conf();
-    if (curr_cpu_count != cpu_count) {
-        cpu_count = curr_cpu_count;
-        free(prev_cpus);
-        prev_cpus = (struct cpu_usage *)calloc(cpu_count, sizeof(struct cpu_usage));
-        free(curr_cpus);
-        curr_cpus = (struct cpu_usage *)calloc(cpu_count, sizeof(struct cpu_usage));
-    }
-
-    memcpy(curr_cpus, prev_cpus, cpu_count * sizeof(struct cpu_usage));
-    FILE *f = fopen(ctx->path, "r");
-    if (f == NULL) {
-        fprintf(stderr, "i3status: open %s: %s\n", ctx->path, strerror(errno));
+    /* The per-CPU lines (cpu0, …) are only parsed when a format displays
+     * them. */
+    const bool by_group = USES_PLACEHOLDER("%socket") || USES_PLACEHOLDER("%node");
+    const bool per_cpu = by_group || USES_PLACEHOLDER("%cpu") || USES_PLACEHOLDER("%max_core") ||
+                         USES_PLACEHOLDER("%min_core") || USES_PLACEHOLDER("%busy_cores") || USES_PLACEHOLDER("%top3");
+    const proc_stat_t *prev;
+    const proc_stat_t *stat = proc_stat_snapshot(ctx->path, per_cpu, &prev);
+    if (stat == NULL)
         goto error;
-    }
-    curr_cpu_count = get_nprocs();
-    char line[4096];
+    if (per_cpu && stat->num_cpus == 0)
+        goto error; /* unexpected EOF */
 
-    /* Discard first line (cpu ), start at second line (cpu0) */
-    if (fgets(line, sizeof(line), f) == NULL) {
-        fclose(f);
-        goto error; /* unexpected EOF or read error */
-    }
+    const cpu_times_t *prev_all = (prev != NULL ? &prev->all : &no_times);
+    const unsigned long long diff_total = counter_delta(cpu_times_total(&stat->all), cpu_times_total(prev_all));
+    diff_usage = usage_between(prev_all, &stat->all);
+    const int iowait = percentage(counter_delta(stat->all.iowait, prev_all->iowait), diff_total);
+    const int steal = percentage(counter_delta(stat->all.steal, prev_all->steal), diff_total);
+    const int irq = percentage(counter_delta(stat->all.irq + stat->all.softirq, prev_all->irq + prev_all->softirq), diff_total);
+    const long long ctxt_rate = rate_between(prev, stat, (prev != NULL ? prev->ctxt : 0), stat->ctxt);
+    const long long fork_rate = rate_between(prev, stat, (prev != NULL ? prev->processes : 0), stat->processes);
 
-    for (int idx = 0; idx < curr_cpu_count; ++idx) {
-        if (fgets(line, sizeof(line), f) == NULL) {
-            fclose(f);
-            goto error; /* unexpected EOF or read error */
+    int max_core = 0, min_core = 0, busy_cores = 0;
+    if (per_cpu) {
+        if (stat->cpus_size != cpu_count) {
+            cpu_count = stat->cpus_size;
+            cpu_usages = srealloc(cpu_usages, cpu_count * sizeof(int));
         }
-        int cpu_idx, user, nice, system, idle;
-        if (sscanf(line, "cpu%d %d %d %d %d", &cpu_idx, &user, &nice, &system, &idle) != 5) {
-            fclose(f);
-            goto error;
-        }
-        if (cpu_idx < 0 || cpu_idx >= cpu_count) {
-            fclose(f);
-            goto error;
+        if (by_group && (cpus_hotplugged() || topology_size != cpu_count))
+            read_topology(cpu_count);
+
+        bool first = true;
+        for (int cpu_idx = 0; cpu_idx < cpu_count; cpu_idx++) {
+            if (!cpu_online(stat, cpu_idx)) {
+                cpu_usages[cpu_idx] = 0;
+                continue;
+            }
+            if (prev == NULL) {
+                cpu_usages[cpu_idx] = usage_between(&no_times, &stat->cpus[cpu_idx]);
+            } else if (prev->has_cpus && cpu_idx < prev->cpus_size && cpu_times_total(&prev->cpus[cpu_idx]) != 0) {
+                /* This includes CPUs which were offline in the previous
+                 * tick, as those keep the times they went offline with. */
+                cpu_usages[cpu_idx] = usage_between(&prev->cpus[cpu_idx], &stat->cpus[cpu_idx]);
+            } else {
+                /* The CPU was never seen before, there is no sample to
+                 * compare with yet. */
+                cpu_usages[cpu_idx] = 0;
+            }
+
+            const int usage = cpu_usages[cpu_idx];
+            if (first || usage > max_core)
+                max_core = usage;
+            if (first || usage < min_core)
+                min_core = usage;
+            if (usage >= ctx->degraded_threshold)
+                busy_cores++;
+            first = false;
         }
-        curr_cpus[cpu_idx].user = user;
-        curr_cpus[cpu_idx].nice = nice;
-        curr_cpus[cpu_idx].system = system;
-        curr_cpus[cpu_idx].idle = idle;
-        curr_cpus[cpu_idx].total = user + nice + system + idle;
     }
-    fclose(f);
-    for (int cpu_idx = 0; cpu_idx < cpu_count; cpu_idx++) {
-        curr_all.user += curr_cpus[cpu_idx].user;
-        curr_all.nice += curr_cpus[cpu_idx].nice;
-        curr_all.system += curr_cpus[cpu_idx].system;
-        curr_all.idle += curr_cpus[cpu_idx].idle;
-        curr_all.total += curr_cpus[cpu_idx].total;
-    }
-
-    diff_idle = curr_all.idle - prev_all.idle;
-    diff_total = curr_all.total - prev_all.total;
-    diff_usage = (diff_total ? (1000 * (diff_total - diff_idle) / diff_total + 5) / 10 : 0);
-    prev_all = curr_all;
 #elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+    struct cpu_usage curr_all = {0, 0, 0, 0, 0};
+    long diff_idle, diff_total;
 
 #if defined(__FreeBSD__) || defined(__DragonFly__) || defined(__NetBSD__)
     size_t size;
@@ -184,6 +365,21 @@ void print_cpu_usage(cpu_usage_ctx_t *ctx) {
     goto error;
 #endif
 
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, diff_usage);
+#if defined(__linux__)
+    fingerprint = fingerprint_bytes(fingerprint, cpu_usages, cpu_count * sizeof(int));
+    FINGERPRINT(fingerprint, iowait);
+    FINGERPRINT(fingerprint, steal);
+    FINGERPRINT(fingerprint, irq);
+    FINGERPRINT(fingerprint, ctxt_rate);
+    FINGERPRINT(fingerprint, fork_rate);
+    FINGERPRINT(fingerprint, stat->procs_running);
+    FINGERPRINT(fingerprint, stat->procs_blocked);
+    FINGERPRINT(fingerprint, cpu_count);
+#endif
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     if (diff_usage >= ctx->max_threshold) {
         START_COLOR("color_bad");
         colorful_output = true;
@@ -201,11 +397,54 @@ void print_cpu_usage(cpu_usage_ctx_t *ctx) {
             *(outwalk++) = *walk;
 
         } else if (BEGINS_WITH(walk + 1, "usage")) {
-            outwalk += sprintf(outwalk, "%02d%s", diff_usage, pct_mark);
+            outwalk += format_int(outwalk, diff_usage, 2, '0');
+            outwalk = stpcpy(outwalk, pct_mark);
             walk += strlen("usage");
         }
 #if defined(__linux__)
-        else if (BEGINS_WITH(walk + 1, "cpu")) {
+        else if (BEGINS_WITH(walk + 1, "iowait")) {
+            outwalk += format_int(outwalk, iowait, 2, '0');
+            outwalk = stpcpy(outwalk, pct_mark);
+            walk += strlen("iowait");
+        } else if (BEGINS_WITH(walk + 1, "steal")) {
+            outwalk += format_int(outwalk, steal, 2, '0');
+            outwalk = stpcpy(outwalk, pct_mark);
+            walk += strlen("steal");
+        } else if (BEGINS_WITH(walk + 1, "irq")) {
+            outwalk += format_int(outwalk, irq, 2, '0');
+            outwalk = stpcpy(outwalk, pct_mark);
+            walk += strlen("irq");
+        } else if (BEGINS_WITH(walk + 1, "ctxt_rate")) {
+            outwalk += format_int(outwalk, ctxt_rate, 0, ' ');
+            walk += strlen("ctxt_rate");
+        } else if (BEGINS_WITH(walk + 1, "fork_rate")) {
+            outwalk += format_int(outwalk, fork_rate, 0, ' ');
+            walk += strlen("fork_rate");
+        } else if (BEGINS_WITH(walk + 1, "procs_running")) {
+            outwalk += format_int(outwalk, stat->procs_running, 0, ' ');
+            walk += strlen("procs_running");
+        } else if (BEGINS_WITH(walk + 1, "procs_blocked")) {
+            outwalk += format_int(outwalk, stat->procs_blocked, 0, ' ');
+            walk += strlen("procs_blocked");
+        } else if (BEGINS_WITH(walk + 1, "max_core")) {
+            outwalk += format_int(outwalk, max_core, 2, '0');
+            outwalk = stpcpy(outwalk, pct_mark);
+            walk += strlen("max_core");
+        } else if (BEGINS_WITH(walk + 1, "min_core")) {
+            outwalk += format_int(outwalk, min_core, 2, '0');
+            outwalk = stpcpy(outwalk, pct_mark);
+            walk += strlen("min_core");
+        } else if (BEGINS_WITH(walk + 1, "busy_cores")) {
+            outwalk += format_int(outwalk, busy_cores, 0, ' ');
+            walk += strlen("busy_cores");
+        } else if (BEGINS_WITH(walk + 1, "top3")) {
+            outwalk = print_top_cpus(outwalk, stat);
+            walk += strlen("top3");
+        } else if (BEGINS_WITH(walk + 1, "socket")) {
+            walk += print_group_usage(&outwalk, walk + 1, "socket", stat, cpu_sockets);
+        } else if (BEGINS_WITH(walk + 1, "node")) {
+            walk += print_group_usage(&outwalk, walk + 1, "node", stat, cpu_nodes);
+        } else if (BEGINS_WITH(walk + 1, "cpu")) {
             int number = -1;
             int length = strlen("cpu");
             sscanf(walk + 1, "cpu%d%n", &number, &length);
@@ -214,10 +453,8 @@ void print_cpu_usage(cpu_usage_ctx_t *ctx) {
             } else if (number >= cpu_count) {
                 fprintf(stderr, "i3status: provided CPU number '%d' above detected number of CPU %d\n", number, cpu_count);
             } else {
-                int cpu_diff_idle = curr_cpus[number].idle - prev_cpus[number].idle;
-                int cpu_diff_total = curr_cpus[number].total - prev_cpus[number].total;
-                int cpu_diff_usage = (cpu_diff_total ? (1000 * (cpu_diff_total - cpu_diff_idle) / cpu_diff_total + 5) / 10 : 0);
-                outwalk += sprintf(outwalk, "%02d%s", cpu_diff_usage, pct_mark);
+                outwalk += format_int(outwalk, cpu_usages[number], 2, '0');
+                outwalk = stpcpy(outwalk, pct_mark);
             }
             walk += length;
         }
@@ -227,10 +464,6 @@ void print_cpu_usage(cpu_usage_ctx_t *ctx) {
         }
     }
 
-    struct cpu_usage *temp_cpus = prev_cpus;
-    prev_cpus = curr_cpus;
-    curr_cpus = temp_cpus;
-
     if (colorful_output)
         END_COLOR;
 
@@ -122,8 +122,8 @@ void print_ddate(ddate_ctx_t *ctx) {
     snprintf(string_B, STRING_SIZE, "%s", season_long[dt->season]);
     snprintf(string_b, STRING_SIZE, "%s", season_short[dt->season]);
     /* Day of the season (ordinal and cardinal) */
-    snprintf(string_d, STRING_SIZE, "%d", dt->season_day + 1);
-    snprintf(string_e, STRING_SIZE, "%d", dt->season_day + 1);
+    format_int(string_d, dt->season_day + 1, 0, ' ');
+    format_int(string_e, dt->season_day + 1, 0, ' ');
     if (dt->season_day > 9 && dt->season_day < 13) {
         strcat(string_e, "th");
     }
@@ -142,7 +142,7 @@ void print_ddate(ddate_ctx_t *ctx) {
             break;
     }
     /* YOLD */
-    snprintf(string_Y, STRING_SIZE, "%d", dt->year);
+    format_int(string_Y, dt->year, 0, ' ');
     /* Holidays */
     if (dt->season_day == 4) {
         snprintf(string_H, STRING_SIZE, "%s", holidays[dt->season]);
@@ -32,17 +32,40 @@ static const char *const si_symbols[MAX_EXPONENT + 1] = {"", "k", "M", "G", "T"}
 static const char *const custom_symbols[MAX_EXPONENT + 1] = {"", "K", "M", "G", "T"};
 
 /*
- * Formats bytes according to the given base and set of symbols.
+ * Divides bytes by the given base until they fit the largest symbol.
  *
  */
-static int format_bytes(char *outwalk, uint64_t bytes, uint64_t base, const char *const symbols[]) {
+static double scale_bytes(uint64_t bytes, uint64_t base, int *exponent) {
     double size = bytes;
-    int exponent = 0;
-    while (size >= base && exponent < MAX_EXPONENT) {
+    *exponent = 0;
+    while (size >= base && *exponent < MAX_EXPONENT) {
         size /= base;
-        exponent += 1;
+        *exponent += 1;
     }
-    return sprintf(outwalk, "%.1f %sB", size, symbols[exponent]);
+    return size;
+}
+
+/*
+ * Formats bytes according to the given base and set of symbols.
+ *
+ */
+static int format_bytes(char *outwalk, uint64_t bytes, uint64_t base, const char *const symbols[]) {
+    int exponent;
+    double size = scale_bytes(bytes, base, &exponent);
+    char *walk = outwalk + format_fixed(outwalk, STRING_SIZE, size, 1);
+    *(walk++) = ' ';
+    walk = stpcpy(walk, symbols[exponent]);
+    walk = stpcpy(walk, "B");
+    return walk - outwalk;
+}
+
+/*
+ * Formats a percentage with one decimal.
+ *
+ */
+static void format_percentage(char *outwalk, double percentage) {
+    outwalk += format_fixed(outwalk, STRING_SIZE, percentage, 1);
+    stpcpy(outwalk, pct_mark);
 }
 
 /*
@@ -59,6 +82,18 @@ static int print_bytes_human(char *outwalk, uint64_t bytes, const char *prefix_t
     }
 }
 
+/*
+ * Adds the given amount of bytes to the fingerprint as it is displayed by
+ * print_bytes_human().
+ *
+ */
+static uint64_t fingerprint_bytes_human(uint64_t fingerprint, uint64_t bytes, const char *prefix_type) {
+    int exponent;
+    double size = scale_bytes(bytes, strcasecmp(prefix_type, "decimal") == 0 ? DECIMAL_BASE : BINARY_BASE, &exponent);
+    FINGERPRINT(fingerprint, exponent);
+    return fingerprint_rounded(fingerprint, size, 1);
+}
+
 /*
  * Determines whether remaining bytes are below given threshold.
  *
@@ -178,11 +213,32 @@ void print_disk_info(disk_info_ctx_t *ctx) {
     }
 #endif
 
+#if defined(__FreeBSD__) || defined(__FreeBSD_kernel__) || defined(__OpenBSD__) || defined(__DragonFly__) || defined(__APPLE__)
+    const uint64_t block_size = buf.f_bsize;
+#else
+    const uint64_t block_size = buf.f_frsize;
+#endif
+    const bool below = mounted && ctx->low_threshold > 0 && below_threshold(buf, ctx->prefix_type, ctx->threshold_type, ctx->low_threshold);
+
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, mounted);
+    FINGERPRINT(fingerprint, below);
+    if (mounted) {
+        fingerprint = fingerprint_bytes_human(fingerprint, block_size * (uint64_t)buf.f_bfree, ctx->prefix_type);
+        fingerprint = fingerprint_bytes_human(fingerprint, block_size * ((uint64_t)buf.f_blocks - (uint64_t)buf.f_bfree), ctx->prefix_type);
+        fingerprint = fingerprint_bytes_human(fingerprint, block_size * (uint64_t)buf.f_blocks, ctx->prefix_type);
+        fingerprint = fingerprint_bytes_human(fingerprint, block_size * (uint64_t)buf.f_bavail, ctx->prefix_type);
+        fingerprint = fingerprint_rounded(fingerprint, 100.0 * (double)buf.f_bfree / (double)buf.f_blocks, 1);
+        fingerprint = fingerprint_rounded(fingerprint, 100.0 * (double)(buf.f_blocks - buf.f_bavail) / (double)buf.f_blocks, 1);
+        fingerprint = fingerprint_rounded(fingerprint, 100.0 * (double)buf.f_bavail / (double)buf.f_blocks, 1);
+    }
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     if (!mounted) {
         if (ctx->format_not_mounted == NULL)
             ctx->format_not_mounted = "";
         selected_format = ctx->format_not_mounted;
-    } else if (ctx->low_threshold > 0 && below_threshold(buf, ctx->prefix_type, ctx->threshold_type, ctx->low_threshold)) {
+    } else if (below) {
         START_COLOR("color_bad");
         colorful_output = true;
         if (ctx->format_below_threshold != NULL)
@@ -198,21 +254,14 @@ void print_disk_info(disk_info_ctx_t *ctx) {
     char string_percentage_used[STRING_SIZE];
     char string_percentage_avail[STRING_SIZE];
 
-#if defined(__FreeBSD__) || defined(__FreeBSD_kernel__) || defined(__OpenBSD__) || defined(__DragonFly__) || defined(__APPLE__)
-    print_bytes_human(string_free, (uint64_t)buf.f_bsize * (uint64_t)buf.f_bfree, ctx->prefix_type);
-    print_bytes_human(string_used, (uint64_t)buf.f_bsize * ((uint64_t)buf.f_blocks - (uint64_t)buf.f_bfree), ctx->prefix_type);
-    print_bytes_human(string_total, (uint64_t)buf.f_bsize * (uint64_t)buf.f_blocks, ctx->prefix_type);
-    print_bytes_human(string_avail, (uint64_t)buf.f_bsize * (uint64_t)buf.f_bavail, ctx->prefix_type);
-#else
-    print_bytes_human(string_free, (uint64_t)buf.f_frsize * (uint64_t)buf.f_bfree, ctx->prefix_type);
-    print_bytes_human(string_used, (uint64_t)buf.f_frsize * ((uint64_t)buf.f_blocks - (uint64_t)buf.f_bfree), ctx->prefix_type);
-    print_bytes_human(string_total, (uint64_t)buf.f_frsize * (uint64_t)buf.f_blocks, ctx->prefix_type);
-    print_bytes_human(string_avail, (uint64_t)buf.f_frsize * (uint64_t)buf.f_bavail, ctx->prefix_type);
-#endif
-    snprintf(string_percentage_free, STRING_SIZE, "%.01f%s", 100.0 * (double)buf.f_bfree / (double)buf.f_blocks, pct_mark);
-    snprintf(string_percentage_used_of_avail, STRING_SIZE, "%.01f%s", 100.0 * (double)(buf.f_blocks - buf.f_bavail) / (double)buf.f_blocks, pct_mark);
-    snprintf(string_percentage_used, STRING_SIZE, "%.01f%s", 100.0 * (double)(buf.f_blocks - buf.f_bfree) / (double)buf.f_blocks, pct_mark);
-    snprintf(string_percentage_avail, STRING_SIZE, "%.01f%s", 100.0 * (double)buf.f_bavail / (double)buf.f_blocks, pct_mark);
+    print_bytes_human(string_free, block_size * (uint64_t)buf.f_bfree, ctx->prefix_type);
+    print_bytes_human(string_used, block_size * ((uint64_t)buf.f_blocks - (uint64_t)buf.f_bfree), ctx->prefix_type);
+    print_bytes_human(string_total, block_size * (uint64_t)buf.f_blocks, ctx->prefix_type);
+    print_bytes_human(string_avail, block_size * (uint64_t)buf.f_bavail, ctx->prefix_type);
+    format_percentage(string_percentage_free, 100.0 * (double)buf.f_bfree / (double)buf.f_blocks);
+    format_percentage(string_percentage_used_of_avail, 100.0 * (double)(buf.f_blocks - buf.f_bavail) / (double)buf.f_blocks);
+    format_percentage(string_percentage_used, 100.0 * (double)(buf.f_blocks - buf.f_bfree) / (double)buf.f_blocks);
+    format_percentage(string_percentage_avail, 100.0 * (double)buf.f_bavail / (double)buf.f_blocks);
 
     placeholder_t placeholders[] = {
         {.name = "%free", .value = string_free},
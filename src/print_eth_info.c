@@ -49,11 +49,14 @@ static int print_eth_speed(char *outwalk, const char *interface) {
         if (ethspeed == 2500) {
             // 2.5 Gbit/s is the only case where floating point formatting is most
             // common.
-            return sprintf(outwalk, "%.1f Gbit/s", (double)ethspeed / 1000);
+            char *walk = outwalk + format_fixed(outwalk, STRING_SIZE, (double)ethspeed / 1000, 1);
+            return stpcpy(walk, " Gbit/s") - outwalk;
         } else if (ethspeed > 1000) {
-            return sprintf(outwalk, "%d Gbit/s", ethspeed / 1000);
+            char *walk = outwalk + format_int(outwalk, ethspeed / 1000, 0, ' ');
+            return stpcpy(walk, " Gbit/s") - outwalk;
         }
-        return sprintf(outwalk, "%d Mbit/s", ethspeed);
+        char *walk = outwalk + format_int(outwalk, ethspeed, 0, ' ');
+        return stpcpy(walk, " Mbit/s") - outwalk;
     } else
         return sprintf(outwalk, "?");
 #elif defined(__FreeBSD__) || defined(__FreeBSD_kernel__) || defined(__DragonFly__)
@@ -152,7 +155,11 @@ void print_eth_info(eth_info_ctx_t *ctx) {
     INSTANCE(ctx->interface);
 
     char *ipv4_address = sstrdup(get_ip_addr(ctx->interface, AF_INET));
-    char *ipv6_address = sstrdup(get_ip_addr(ctx->interface, AF_INET6));
+    /* The IPv6 address is only displayed (and only decides whether the
+     * interface is up) when there is no IPv4 address. */
+    char *ipv6_address = NULL;
+    if (ipv4_address == NULL || BEGINS_WITH(ipv4_address, "no IP"))
+        ipv6_address = sstrdup(get_ip_addr(ctx->interface, AF_INET6));
 
     /*
      * Removing '%' and following characters from IPv6 since the interface identifier is redundant,
@@ -179,19 +186,30 @@ void print_eth_info(eth_info_ctx_t *ctx) {
 
     format = ctx->format_up;
 
-    const char *ip_address = (prefer_ipv4) ? ipv4_address : ipv6_address;
-    if (BEGINS_WITH(ip_address, "no IP")) {
+    char string_ip[STRING_SIZE];
+    char string_speed[STRING_SIZE];
+    char string_interface[STRING_SIZE];
+    snprintf(string_ip, STRING_SIZE, "%s", (prefer_ipv4) ? ipv4_address : ipv6_address);
+    string_speed[0] = '\0';
+    if (FORMATS_USE("%speed", ctx->format_up))
+        print_eth_speed(string_speed, ctx->interface);
+    snprintf(string_interface, STRING_SIZE, "%s", ctx->interface);
+    free(ipv4_address);
+    free(ipv6_address);
+    ipv4_address = ipv6_address = NULL;
+
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    fingerprint = fingerprint_str(fingerprint, string_ip);
+    fingerprint = fingerprint_str(fingerprint, string_speed);
+    fingerprint = fingerprint_str(fingerprint, string_interface);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
+    if (BEGINS_WITH(string_ip, "no IP")) {
         START_COLOR("color_degraded");
     } else {
         START_COLOR("color_good");
     }
 
-    char string_ip[STRING_SIZE];
-    char string_speed[STRING_SIZE];
-    char string_interface[STRING_SIZE];
-    snprintf(string_ip, STRING_SIZE, "%s", ip_address);
-    print_eth_speed(string_speed, ctx->interface);
-    snprintf(string_interface, STRING_SIZE, "%s", ctx->interface);
     placeholder_t placeholders[] = {
         {.name = "%ip", .value = string_ip},
         {.name = "%speed", .value = string_speed},
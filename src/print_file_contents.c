@@ -8,41 +8,130 @@
 #include <sys/types.h>
 
 #include <sys/fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <regex.h>
+#include <time.h>
 #include "i3status.h"
 
 #define STRING_SIZE 10
 
-void print_file_contents(file_contents_ctx_t *ctx) {
-    const char *walk = ctx->format;
-    char *outwalk = ctx->buf;
-    char *buf = scalloc(ctx->max_chars * sizeof(char) + 1);
+/* When a file is first tailed, its last line is looked for in this many
+ * bytes at its end. */
+#define TAIL_SCAN_SIZE 65536
 
-    if (ctx->path == NULL) {
-        OUTPUT_FULL_TEXT("error: path not configured");
-        free(buf);
-        return;
-    }
+/* %lines_per_min counts the lines of the last minute in one bucket per
+ * second. */
+#define LINE_RATE_SECONDS 60
 
-    char *abs_path = resolve_tilde(ctx->path);
-    int fd = open(abs_path, O_RDONLY);
-    free(abs_path);
+/* The number of capture groups of regex, %1 to %9. */
+#define NUM_CAPTURES 9
 
-    INSTANCE(ctx->path);
+/*
+ * The contents of a file are kept until file_watch() reports that the file
+ * changed, so that an update only reads files which were written since the
+ * last one, and a write shows up right away. Files which cannot be watched
+ * (e.g. in procfs and sysfs) are read on every update.
+ *
+ */
+typedef struct {
+    char *path;
+    int max_chars;
+    bool tail;
+    char *pattern;
+    char *regex;
+    /* The path with the tilde expanded. */
+    char *resolved;
+    unsigned int changes;
+    unsigned int seen;
+    /* Whether the file was read yet. */
+    bool read;
+    bool opened;
+    int read_errno;
+    /* The contents without newlines, max_chars + 1 bytes. In tail mode, the
+     * last (matching) line. */
+    char *contents;
+
+    /* The regular expressions, compiled once. */
+    regex_t pattern_regex;
+    regex_t extract_regex;
+    bool regex_valid;
+    /* The capture groups of regex in contents, max_chars + 1 bytes each, and
+     * whether they were extracted from the current contents. */
+    char *captures[NUM_CAPTURES];
+    bool extracted;
 
-    int n = -1;
-    if (fd > -1) {
-        n = read(fd, buf, ctx->max_chars);
-        if (n != -1) {
-            buf[n] = '\0';
+    /* In tail mode, the file which is read, and how far. */
+    int fd;
+    dev_t dev;
+    ino_t ino;
+    off_t offset;
+    /* The beginning of the line which is being appended, max_chars + 1
+     * bytes. */
+    char *partial;
+    size_t partial_len;
+    /* The number of lines appended in each second of the last minute. */
+    time_t line_seconds[LINE_RATE_SECONDS];
+    unsigned int line_counts[LINE_RATE_SECONDS];
+} file_state_t;
+
+/* Allocated one by one, as file_watch() keeps a pointer to their changes. */
+static file_state_t **files = NULL;
+static int num_files = 0;
+
+static bool same_option(const char *a, const char *b) {
+    return (a == NULL ? b == NULL : (b != NULL && strcmp(a, b) == 0));
+}
+
+static file_state_t *file_state(file_contents_ctx_t *ctx) {
+    for (int i = 0; i < num_files; i++) {
+        file_state_t *file = files[i];
+        if (file->max_chars == ctx->max_chars && file->tail == ctx->tail && strcmp(file->path, ctx->path) == 0 &&
+            same_option(file->pattern, ctx->pattern) && same_option(file->regex, ctx->regex))
+            return file;
+    }
+    file_state_t *file = scalloc(sizeof(file_state_t));
+    file->path = sstrdup(ctx->path);
+    file->max_chars = ctx->max_chars;
+    file->tail = ctx->tail;
+    file->resolved = resolve_tilde(ctx->path);
+    file->contents = scalloc(ctx->max_chars + 1);
+    file->fd = -1;
+    file->regex_valid = true;
+    if (ctx->tail) {
+        file->partial = scalloc(ctx->max_chars + 1);
+        if (ctx->pattern != NULL) {
+            file->pattern = sstrdup(ctx->pattern);
+            file->regex_valid &= (regcomp(&file->pattern_regex, ctx->pattern, REG_EXTENDED | REG_NOSUB) == 0);
         }
-        (void)close(fd);
-        START_COLOR("color_good");
-    } else if (errno != 0) {
-        walk = ctx->format_bad;
-        START_COLOR("color_bad");
     }
+    if (ctx->regex != NULL) {
+        file->regex = sstrdup(ctx->regex);
+        file->regex_valid &= (regcomp(&file->extract_regex, ctx->regex, REG_EXTENDED) == 0);
+        for (int i = 0; i < NUM_CAPTURES; i++)
+            file->captures[i] = scalloc(ctx->max_chars + 1);
+    }
+    files = srealloc(files, (num_files + 1) * sizeof(file_state_t *));
+    files[num_files++] = file;
+    return file;
+}
+
+static void read_contents(file_state_t *file) {
+    const bool watched = file_watch(file->resolved, false, &file->changes);
+    if (file->read && watched && file->seen == file->changes)
+        return;
+
+    file->seen = file->changes;
+    file->extracted = false;
+    char *buf = file->contents;
+    buf[0] = '\0';
+    errno = 0;
+    ssize_t n = fd_cache_pread(file->resolved, buf, file->max_chars, &file->opened);
+    if (n != -1)
+        buf[n] = '\0';
+    file->read_errno = errno;
+    file->read = true;
 
     // remove newline chars
     char *src, *dst;
@@ -53,22 +142,284 @@ void print_file_contents(file_contents_ctx_t *ctx) {
         }
     }
     *dst = '\0';
+}
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static void count_line(file_state_t *file) {
+    const time_t now = monotonic_seconds();
+    const int bucket = now % LINE_RATE_SECONDS;
+    if (file->line_seconds[bucket] != now) {
+        file->line_seconds[bucket] = now;
+        file->line_counts[bucket] = 0;
+    }
+    file->line_counts[bucket]++;
+}
+
+static unsigned int lines_per_min(const file_state_t *file) {
+    const time_t now = monotonic_seconds();
+    unsigned int lines = 0;
+    for (int i = 0; i < LINE_RATE_SECONDS; i++) {
+        if (file->line_counts[i] > 0 && now - file->line_seconds[i] < LINE_RATE_SECONDS)
+            lines += file->line_counts[i];
+    }
+    return lines;
+}
+
+/*
+ * Takes the line which was completed (cut to max_chars) as the last line,
+ * unless it does not match the pattern. Lines which were in the file before it
+ * was first tailed are not counted in %lines_per_min.
+ *
+ */
+static void tail_line(file_state_t *file, bool count) {
+    file->partial[file->partial_len] = '\0';
+    file->partial_len = 0;
+    if (file->pattern != NULL && regexec(&file->pattern_regex, file->partial, 0, NULL, 0) != 0)
+        return;
+    memcpy(file->contents, file->partial, file->max_chars + 1);
+    file->extracted = false;
+    if (count)
+        count_line(file);
+}
+
+static void tail_bytes(file_state_t *file, const char *buf, size_t n, bool count) {
+    const char *end = buf + n;
+    while (buf < end) {
+        const char *newline = memchr(buf, '\n', end - buf);
+        const size_t len = (newline == NULL ? end : newline) - buf;
+        const size_t room = file->max_chars - file->partial_len;
+        const size_t copy = (len < room ? len : room);
+        memcpy(file->partial + file->partial_len, buf, copy);
+        file->partial_len += copy;
+        if (newline == NULL)
+            return;
+        tail_line(file, count);
+        buf = newline + 1;
+    }
+}
+
+/*
+ * Reads what was appended to the file since the last call.
+ *
+ */
+static void tail_appended(file_state_t *file) {
+    char buf[4096];
+    ssize_t n;
+    while ((n = pread(file->fd, buf, sizeof(buf), file->offset)) > 0) {
+        file->offset += n;
+        tail_bytes(file, buf, n, true);
+    }
+}
+
+/*
+ * Opens the file and looks for its last line at its end. When the file
+ * replaced the one which was tailed before (e.g. by log rotation), it is read
+ * from its beginning instead.
+ *
+ */
+static bool tail_open(file_state_t *file, bool rotated) {
+    int fd = open(file->resolved, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1)
+        return false;
+    if (fstat(fd, &st) == -1) {
+        const int stat_errno = errno;
+        (void)close(fd);
+        errno = stat_errno;
+        return false;
+    }
+
+    if (file->fd != -1)
+        (void)close(file->fd);
+    file->fd = fd;
+    file->dev = st.st_dev;
+    file->ino = st.st_ino;
+    file->partial_len = 0;
+    file->offset = 0;
+    if (rotated || st.st_size == 0)
+        return true;
+
+    const off_t start = (st.st_size > TAIL_SCAN_SIZE ? st.st_size - TAIL_SCAN_SIZE : 0);
+    char *buf = scalloc(TAIL_SCAN_SIZE);
+    const ssize_t n = pread(fd, buf, TAIL_SCAN_SIZE, start);
+    if (n > 0) {
+        const char *walk = buf;
+        if (start > 0) {
+            /* Skip the line which began before the scanned part. */
+            const char *newline = memchr(buf, '\n', n);
+            walk = (newline == NULL ? buf + n : newline + 1);
+        }
+        tail_bytes(file, walk, buf + n - walk, false);
+        file->offset = start + n;
+    }
+    free(buf);
+    return true;
+}
+
+/*
+ * Follows the file like tail -F: only the bytes which were appended are read.
+ * When the file was truncated, it is read from its beginning again, and when
+ * it was replaced, the rest of the old file is read before the new one.
+ *
+ */
+static void read_tail(file_state_t *file) {
+    const bool watched = file_watch(file->resolved, false, &file->changes);
+    if (file->read && watched && file->seen == file->changes)
+        return;
+    file->seen = file->changes;
+    file->read = true;
+
+    struct stat st;
+    if (stat(file->resolved, &st) == -1) {
+        /* The file was renamed and its replacement does not exist yet. */
+        if (file->fd != -1) {
+            tail_appended(file);
+            return;
+        }
+        file->opened = false;
+        file->read_errno = errno;
+        return;
+    }
+
+    if (file->fd == -1 || st.st_dev != file->dev || st.st_ino != file->ino) {
+        const bool rotated = (file->fd != -1);
+        if (rotated)
+            tail_appended(file);
+        if (!tail_open(file, rotated)) {
+            file->opened = false;
+            file->read_errno = errno;
+            return;
+        }
+    } else if (st.st_size < file->offset) {
+        /* The file was truncated. */
+        file->offset = 0;
+        file->partial_len = 0;
+    }
+    file->opened = true;
+    file->read_errno = 0;
+    tail_appended(file);
+}
+
+/*
+ * Extracts the capture groups of regex from the contents. They are empty if
+ * regex does not match.
+ *
+ */
+static void extract_captures(file_state_t *file) {
+    if (file->regex == NULL || file->extracted)
+        return;
+    file->extracted = true;
+
+    regmatch_t matches[NUM_CAPTURES + 1];
+    const bool matched = (regexec(&file->extract_regex, file->contents, NUM_CAPTURES + 1, matches, 0) == 0);
+    for (int i = 0; i < NUM_CAPTURES; i++) {
+        const regmatch_t *match = &matches[i + 1];
+        if (!matched || match->rm_so == -1) {
+            file->captures[i][0] = '\0';
+            continue;
+        }
+        const int len = match->rm_eo - match->rm_so;
+        memcpy(file->captures[i], file->contents + match->rm_so, len);
+        file->captures[i][len] = '\0';
+    }
+}
+
+/*
+ * Returns the color of the threshold which the value of the capture group
+ * crossed, or NULL.
+ *
+ */
+static const char *capture_color(file_contents_ctx_t *ctx, file_state_t *file) {
+    if (file->regex == NULL || ctx->threshold_capture < 1 || ctx->threshold_capture > NUM_CAPTURES)
+        return NULL;
+    const char *capture = file->captures[ctx->threshold_capture - 1];
+    char *end;
+    const double value = strtod(capture, &end);
+    if (end == capture)
+        return NULL;
+    return threshold_color(value, ctx->threshold_degraded, ctx->threshold_critical);
+}
+
+void print_file_contents(file_contents_ctx_t *ctx) {
+    const char *walk = ctx->format;
+    char *outwalk = ctx->buf;
+
+    if (ctx->path == NULL) {
+        OUTPUT_FULL_TEXT("error: path not configured");
+        return;
+    }
+
+    file_state_t *file = file_state(ctx);
+    if (!file->regex_valid) {
+        OUTPUT_FULL_TEXT("error: invalid regular expression");
+        return;
+    }
+    if (file->tail)
+        read_tail(file);
+    else
+        read_contents(file);
+    extract_captures(file);
+    const char *crossed = (file->opened ? capture_color(ctx, file) : NULL);
+    const bool opened = file->opened;
+    const int read_errno = file->read_errno;
+    const char *buf = file->contents;
+    const unsigned int line_rate = (file->tail ? lines_per_min(file) : 0);
+
+    INSTANCE(ctx->path);
+
+    if (!opened && read_errno != 0) {
+        walk = ctx->format_bad;
+    }
+
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, opened);
+    FINGERPRINT(fingerprint, read_errno);
+    FINGERPRINT(fingerprint, line_rate);
+    fingerprint = fingerprint_str(fingerprint, buf);
+    fingerprint = fingerprint_str(fingerprint, (crossed != NULL ? crossed : ""));
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
+    if (crossed != NULL) {
+        START_COLOR(crossed);
+    } else if (opened) {
+        START_COLOR("color_good");
+    } else if (read_errno != 0) {
+        START_COLOR("color_bad");
+    }
 
     char string_errno[STRING_SIZE];
+    char string_lines_per_min[STRING_SIZE];
 
-    sprintf(string_errno, "%d", errno);
+    format_int(string_errno, read_errno, 0, ' ');
+    format_int(string_lines_per_min, line_rate, 0, ' ');
 
     placeholder_t placeholders[] = {
         {.name = "%title", .value = ctx->title},
         {.name = "%content", .value = buf},
+        {.name = "%last_line", .value = buf},
+        {.name = "%lines_per_min", .value = string_lines_per_min},
         {.name = "%errno", .value = string_errno},
-        {.name = "%error", .value = strerror(errno)}};
+        {.name = "%error", .value = strerror(read_errno)},
+        {.name = "%1", .value = file->captures[0]},
+        {.name = "%2", .value = file->captures[1]},
+        {.name = "%3", .value = file->captures[2]},
+        {.name = "%4", .value = file->captures[3]},
+        {.name = "%5", .value = file->captures[4]},
+        {.name = "%6", .value = file->captures[5]},
+        {.name = "%7", .value = file->captures[6]},
+        {.name = "%8", .value = file->captures[7]},
+        {.name = "%9", .value = file->captures[8]}};
 
-    const size_t num = sizeof(placeholders) / sizeof(placeholder_t);
+    /* The capture groups are only placeholders when regex is set. */
+    const size_t num = sizeof(placeholders) / sizeof(placeholder_t) - (file->regex == NULL ? NUM_CAPTURES : 0);
     char *formatted = format_placeholders(walk, &placeholders[0], num);
     OUTPUT_FORMATTED;
     free(formatted);
-    free(buf);
 
     END_COLOR;
     OUTPUT_FULL_TEXT(ctx->buf);
@@ -3,6 +3,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -38,6 +39,52 @@ static char *strip_optional_label(const char *ifa_name) {
     return copy;
 }
 
+#if defined(__linux__)
+/*
+ * Looks up the IP address in the tables which are kept up to date through
+ * netlink, like get_ip_addr(). Returns false if they are not available.
+ *
+ */
+static bool get_rtnetlink_addr(const char *interface, int family, char *part, size_t size, const char **result) {
+    const net_link_t *links;
+    const net_address_t *addresses;
+    int num_links, num_addresses;
+    if (!rtnetlink_links(&links, &num_links) || !rtnetlink_addresses(&addresses, &num_addresses))
+        return false;
+
+    const net_link_t *link = NULL;
+    for (int i = 0; i < num_links; i++) {
+        if (strcmp(links[i].name, interface) == 0) {
+            link = &links[i];
+            break;
+        }
+    }
+    if (link == NULL || (link->flags & IFF_RUNNING) == 0) {
+        *result = NULL;
+        return true;
+    }
+
+    for (int i = 0; i < num_addresses; i++) {
+        const net_address_t *address = &addresses[i];
+        if (address->index != link->index || address->family != family)
+            continue;
+        if (inet_ntop(family, address->address, part, size) == NULL) {
+            *result = "no IP";
+            return true;
+        }
+        /* Like getnameinfo(), name the scope of link-local addresses. */
+        if (family == AF_INET6 && IN6_IS_ADDR_LINKLOCAL((const struct in6_addr *)address->address)) {
+            const size_t len = strlen(part);
+            snprintf(part + len, size - len, "%%%s", link->name);
+        }
+        *result = part;
+        return true;
+    }
+    *result = "no IP";
+    return true;
+}
+#endif
+
 /*
  * Return the IP address for the given interface or "no IP" if the
  * interface is up and running but hasn't got an IP address yet
@@ -45,6 +92,12 @@ static char *strip_optional_label(const char *ifa_name) {
  */
 const char *get_ip_addr(const char *interface, int family) {
     static char part[512];
+#if defined(__linux__)
+    const char *result;
+    if (get_rtnetlink_addr(interface, family, part, sizeof(part), &result))
+        return result;
+#endif
+
     socklen_t len = 0;
     if (family == AF_INET)
         len = sizeof(struct sockaddr_in);
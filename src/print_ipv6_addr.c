@@ -67,7 +67,7 @@ static char *get_sockname(struct addrinfo *addr) {
  * Returns the IPv6 address with which you have connectivity at the moment.
  * The char * is statically allocated and mustn't be freed
  */
-static char *get_ipv6_addr(void) {
+static char *lookup_ipv6_addr(void) {
     struct addrinfo hints;
     struct addrinfo *result, *resp;
     static struct addrinfo *cached = NULL;
@@ -119,6 +119,59 @@ static char *get_ipv6_addr(void) {
     return NULL;
 }
 
+/*
+ * Like lookup_ipv6_addr(), but the address is only looked up again after
+ * netlink announced that an address or route changed.
+ *
+ */
+static char *get_ipv6_addr(void) {
+    static char *addr_string = NULL;
+    static bool looked_up = false;
+    static unsigned int looked_up_generation;
+
+    unsigned int generation;
+    if (!rtnetlink_generation(&generation))
+        return lookup_ipv6_addr();
+    if (!looked_up || generation != looked_up_generation) {
+        /* Points to the buffer of get_sockname(), which is only overwritten
+         * by the next lookup. */
+        addr_string = lookup_ipv6_addr();
+        looked_up = true;
+        looked_up_generation = generation;
+    }
+    return addr_string;
+}
+
+/*
+ * Looks up the interface of the given IPv6 address in the tables which are
+ * kept up to date through netlink. Returns false if they are not available.
+ *
+ */
+static bool get_rtnetlink_iface(const char *searched_addr_string, char *iface_string, size_t size) {
+    const net_link_t *links;
+    const net_address_t *addresses;
+    int num_links, num_addresses;
+    if (!rtnetlink_links(&links, &num_links) || !rtnetlink_addresses(&addresses, &num_addresses))
+        return false;
+
+    struct in6_addr searched;
+    if (inet_pton(AF_INET6, searched_addr_string, &searched) != 1)
+        return false;
+
+    for (int i = 0; i < num_addresses; i++) {
+        if (addresses[i].family != AF_INET6 || memcmp(addresses[i].address, &searched, sizeof(searched)) != 0)
+            continue;
+        for (int j = 0; j < num_links; j++) {
+            if (links[j].index == addresses[i].index) {
+                snprintf(iface_string, size, "%s", links[j].name);
+                return true;
+            }
+        }
+    }
+    fprintf(stderr, "No matching interface found for the outgoing IPv6\n");
+    return true;
+}
+
 /*
  * Returns the name of the interface with which the given IPv6 address is
  * associated.
@@ -132,6 +185,9 @@ char *get_iface_addr(const char *searched_addr_string) {
         return iface_string;
     }
 
+    if (get_rtnetlink_iface(searched_addr_string, iface_string, sizeof(iface_string)))
+        return iface_string;
+
     /* getifaddrs(3) returns a linked list of all the available IP addresses on
      * the system. */
     if (getifaddrs(&addresses) == -1) {
@@ -192,6 +248,11 @@ void print_ipv6_info(ipv6_info_ctx_t *ctx) {
         return;
     }
 
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    fingerprint = fingerprint_str(fingerprint, addr_string);
+    fingerprint = fingerprint_str(fingerprint, iface_string);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     START_COLOR("color_good");
 
     placeholder_t placeholders[] = {
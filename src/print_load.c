@@ -23,6 +23,10 @@ void print_load(load_ctx_t *ctx) {
     if (getloadavg(loadavg, 3) == -1)
         goto error;
 
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, loadavg);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     if (loadavg[0] >= ctx->max_threshold) {
         START_COLOR("color_bad");
         colorful_output = true;
@@ -34,9 +38,9 @@ void print_load(load_ctx_t *ctx) {
     char string_loadavg_5[STRING_SIZE];
     char string_loadavg_15[STRING_SIZE];
 
-    snprintf(string_loadavg_1, STRING_SIZE, "%1.2f", loadavg[0]);
-    snprintf(string_loadavg_5, STRING_SIZE, "%1.2f", loadavg[1]);
-    snprintf(string_loadavg_15, STRING_SIZE, "%1.2f", loadavg[2]);
+    format_fixed(string_loadavg_1, sizeof(string_loadavg_1), loadavg[0], 2);
+    format_fixed(string_loadavg_5, sizeof(string_loadavg_5), loadavg[1], 2);
+    format_fixed(string_loadavg_15, sizeof(string_loadavg_15), loadavg[2], 2);
 
     placeholder_t placeholders[] = {
         {.name = "%1min", .value = string_loadavg_1},
@@ -1,6 +1,7 @@
 // vim:ts=4:sw=4:expandtab
 #include <config.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <yajl/yajl_gen.h>
@@ -19,30 +20,122 @@ static const char *const iec_symbols[] = {"B", "KiB", "MiB", "GiB", "TiB"};
 
 #if defined(__linux__)
 /*
- * Prints the given amount of bytes in a human readable manner.
+ * Divides bytes by the binary base until they fit the largest symbol or the
+ * given unit.
  *
  */
-static int print_bytes_human(char *outwalk, unsigned long bytes, const char *unit, const int decimals) {
+static double scale_bytes(unsigned long bytes, const char *unit, size_t *exponent) {
     double base = bytes;
-    size_t exponent = 0;
-    while (base >= BINARY_BASE && exponent < MAX_EXPONENT) {
-        if (strcasecmp(unit, iec_symbols[exponent]) == 0) {
+    *exponent = 0;
+    while (base >= BINARY_BASE && *exponent < MAX_EXPONENT) {
+        if (strcasecmp(unit, iec_symbols[*exponent]) == 0) {
             break;
         }
 
         base /= BINARY_BASE;
-        exponent += 1;
+        *exponent += 1;
     }
+    return base;
+}
+
+/*
+ * Prints the given amount of bytes in a human readable manner.
+ *
+ */
+static int print_bytes_human(char *outwalk, unsigned long bytes, const char *unit, const int decimals) {
+    size_t exponent;
+    double base = scale_bytes(bytes, unit, &exponent);
     const int prec = decimals > MAX_DECIMALS ? MAX_DECIMALS : decimals;
-    return sprintf(outwalk, "%.*f %s", prec, base, iec_symbols[exponent]);
+    char *walk = outwalk + format_fixed(outwalk, STRING_SIZE, base, prec);
+    *(walk++) = ' ';
+    walk = stpcpy(walk, iec_symbols[exponent]);
+    return walk - outwalk;
+}
+
+/*
+ * Adds the given amount of bytes to the fingerprint as it is displayed by
+ * print_bytes_human().
+ *
+ */
+static uint64_t fingerprint_bytes_human(uint64_t fingerprint, unsigned long bytes, const char *unit, const int decimals) {
+    size_t exponent;
+    double base = scale_bytes(bytes, unit, &exponent);
+    FINGERPRINT(fingerprint, exponent);
+    return fingerprint_rounded(fingerprint, base, decimals > MAX_DECIMALS ? MAX_DECIMALS : decimals);
 }
 
 static int print_percentage(char *outwalk, float percent) {
-    return snprintf(outwalk, STRING_SIZE, "%.1f%s", percent, pct_mark);
+    char *walk = outwalk + format_fixed(outwalk, STRING_SIZE, percent, 1);
+    walk = stpcpy(walk, pct_mark);
+    return walk - outwalk;
 }
 #endif
 
 #if defined(__linux__)
+/* The fields of /proc/meminfo which are used. The ones up to and including
+ * MEMINFO_SHMEM are required, the others are 0 if the kernel does not have
+ * them. */
+typedef enum {
+    MEMINFO_MEM_TOTAL,
+    MEMINFO_MEM_FREE,
+    MEMINFO_MEM_AVAILABLE,
+    MEMINFO_BUFFERS,
+    MEMINFO_CACHED,
+    MEMINFO_SHMEM,
+    MEMINFO_SWAP_TOTAL,
+    MEMINFO_SWAP_FREE,
+    MEMINFO_DIRTY,
+    MEMINFO_WRITEBACK,
+    MEMINFO_ANON_HUGE_PAGES,
+    MEMINFO_SLAB,
+    MEMINFO_COMMITTED_AS,
+    MEMINFO_FIELDS
+} meminfo_field_t;
+
+#define MEMINFO_REQUIRED ((1U << (MEMINFO_SHMEM + 1)) - 1)
+
+static const char *const meminfo_names[MEMINFO_FIELDS] = {
+    "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "Shmem", "SwapTotal",
+    "SwapFree", "Dirty", "Writeback", "AnonHugePages", "Slab", "Committed_AS"};
+
+#define MEMINFO_HASH_SIZE 32
+
+/*
+ * Hashes the name of a /proc/meminfo field. The factors are chosen so that
+ * every name in meminfo_names gets its own slot, which is verified when the
+ * table is built.
+ *
+ */
+static unsigned int meminfo_hash(const char *name, size_t len) {
+    return (len + (unsigned char)name[0] * 2 + (unsigned char)name[len - 1] * 14) % MEMINFO_HASH_SIZE;
+}
+
+/*
+ * Returns the field with the given name or -1 if it is not used.
+ *
+ */
+static int meminfo_lookup(const char *name, size_t len) {
+    static signed char table[MEMINFO_HASH_SIZE];
+    static bool initialized = false;
+    if (!initialized) {
+        memset(table, -1, sizeof(table));
+        for (int field = 0; field < MEMINFO_FIELDS; field++) {
+            const unsigned int slot = meminfo_hash(meminfo_names[field], strlen(meminfo_names[field]));
+            if (table[slot] != -1)
+                die("i3status: meminfo_hash() maps %s and %s to the same slot\n", meminfo_names[table[slot]], meminfo_names[field]);
+            table[slot] = field;
+        }
+        initialized = true;
+    }
+
+    if (len == 0)
+        return -1;
+    const int field = table[meminfo_hash(name, len)];
+    if (field == -1 || strncmp(meminfo_names[field], name, len) != 0 || meminfo_names[field][len] != '\0')
+        return -1;
+    return field;
+}
+
 /*
  * Convert a string to its absolute representation based on the total
  * memory of `mem_total`.
@@ -93,51 +186,47 @@ void print_memory(memory_ctx_t *ctx) {
     const char *selected_format = ctx->format;
     const char *output_color = NULL;
 
-    int unread_fields = 6;
-    unsigned long ram_total;
-    unsigned long ram_free;
-    unsigned long ram_available;
-    unsigned long ram_buffers;
-    unsigned long ram_cached;
-    unsigned long ram_shared;
-
-    FILE *file = fopen("/proc/meminfo", "r");
-    if (!file) {
+    static char meminfo[8192];
+    ssize_t len = fd_cache_pread("/proc/meminfo", meminfo, sizeof(meminfo) - 1, NULL);
+    if (len == -1) {
         goto error;
     }
-    for (char line[128]; fgets(line, sizeof line, file);) {
-        if (BEGINS_WITH(line, "MemTotal:")) {
-            ram_total = strtoul(line + strlen("MemTotal:"), NULL, 10);
-        } else if (BEGINS_WITH(line, "MemFree:")) {
-            ram_free = strtoul(line + strlen("MemFree:"), NULL, 10);
-        } else if (BEGINS_WITH(line, "MemAvailable:")) {
-            ram_available = strtoul(line + strlen("MemAvailable:"), NULL, 10);
-        } else if (BEGINS_WITH(line, "Buffers:")) {
-            ram_buffers = strtoul(line + strlen("Buffers:"), NULL, 10);
-        } else if (BEGINS_WITH(line, "Cached:")) {
-            ram_cached = strtoul(line + strlen("Cached:"), NULL, 10);
-        } else if (BEGINS_WITH(line, "Shmem:")) {
-            ram_shared = strtoul(line + strlen("Shmem:"), NULL, 10);
-        } else {
+    meminfo[len] = '\0';
+
+    unsigned long values[MEMINFO_FIELDS] = {0};
+    unsigned int found = 0;
+    for (const char *line = meminfo, *next; *line != '\0' && found != (1U << MEMINFO_FIELDS) - 1; line = next) {
+        next = strchrnul(line, '\n');
+        const char *colon = memchr(line, ':', next - line);
+        if (*next == '\n')
+            next++;
+        if (colon == NULL)
             continue;
-        }
-        if (--unread_fields == 0) {
-            break;
+
+        const int field = meminfo_lookup(line, colon - line);
+        if (field != -1) {
+            values[field] = strtoul(colon + 1, NULL, 10);
+            found |= 1U << field;
         }
     }
-    fclose(file);
 
-    if (unread_fields > 0) {
+    if ((found & MEMINFO_REQUIRED) != MEMINFO_REQUIRED) {
         goto error;
     }
 
     // Values are in kB, convert them to B.
-    ram_total *= 1024UL;
-    ram_free *= 1024UL;
-    ram_available *= 1024UL;
-    ram_buffers *= 1024UL;
-    ram_cached *= 1024UL;
-    ram_shared *= 1024UL;
+    for (int field = 0; field < MEMINFO_FIELDS; field++) {
+        values[field] *= 1024UL;
+    }
+    const unsigned long ram_total = values[MEMINFO_MEM_TOTAL];
+    const unsigned long ram_free = values[MEMINFO_MEM_FREE];
+    const unsigned long ram_available = values[MEMINFO_MEM_AVAILABLE];
+    const unsigned long ram_buffers = values[MEMINFO_BUFFERS];
+    const unsigned long ram_cached = values[MEMINFO_CACHED];
+    const unsigned long ram_shared = values[MEMINFO_SHMEM];
+    const unsigned long swap_total = values[MEMINFO_SWAP_TOTAL];
+    const unsigned long swap_free = values[MEMINFO_SWAP_FREE];
+    const unsigned long swap_used = (swap_total > swap_free ? swap_total - swap_free : 0);
 
     unsigned long ram_used;
     if (BEGINS_WITH(ctx->memory_used_method, "memavailable")) {
@@ -162,6 +251,25 @@ void print_memory(memory_ctx_t *ctx) {
         }
     }
 
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    fingerprint = fingerprint_str(fingerprint, output_color);
+    fingerprint = fingerprint_bytes_human(fingerprint, ram_total, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, ram_used, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, ram_free, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, ram_available, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, ram_shared, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, swap_total, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, swap_free, ctx->unit, ctx->decimals);
+    fingerprint = fingerprint_bytes_human(fingerprint, swap_used, ctx->unit, ctx->decimals);
+    for (int field = MEMINFO_DIRTY; field < MEMINFO_FIELDS; field++) {
+        fingerprint = fingerprint_bytes_human(fingerprint, values[field], ctx->unit, ctx->decimals);
+    }
+    fingerprint = fingerprint_rounded(fingerprint, (float)(100.0 * ram_free / ram_total), 1);
+    fingerprint = fingerprint_rounded(fingerprint, (float)(100.0 * ram_available / ram_total), 1);
+    fingerprint = fingerprint_rounded(fingerprint, (float)(100.0 * ram_used / ram_total), 1);
+    fingerprint = fingerprint_rounded(fingerprint, (float)(100.0 * ram_shared / ram_total), 1);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     if (output_color) {
         START_COLOR(output_color);
 
@@ -174,6 +282,14 @@ void print_memory(memory_ctx_t *ctx) {
     char string_ram_free[STRING_SIZE];
     char string_ram_available[STRING_SIZE];
     char string_ram_shared[STRING_SIZE];
+    char string_swap_total[STRING_SIZE];
+    char string_swap_free[STRING_SIZE];
+    char string_swap_used[STRING_SIZE];
+    char string_dirty[STRING_SIZE];
+    char string_writeback[STRING_SIZE];
+    char string_anon_huge_pages[STRING_SIZE];
+    char string_slab[STRING_SIZE];
+    char string_committed_as[STRING_SIZE];
     char string_percentage_free[STRING_SIZE];
     char string_percentage_available[STRING_SIZE];
     char string_percentage_used[STRING_SIZE];
@@ -184,6 +300,14 @@ void print_memory(memory_ctx_t *ctx) {
     print_bytes_human(string_ram_free, ram_free, ctx->unit, ctx->decimals);
     print_bytes_human(string_ram_available, ram_available, ctx->unit, ctx->decimals);
     print_bytes_human(string_ram_shared, ram_shared, ctx->unit, ctx->decimals);
+    print_bytes_human(string_swap_total, swap_total, ctx->unit, ctx->decimals);
+    print_bytes_human(string_swap_free, swap_free, ctx->unit, ctx->decimals);
+    print_bytes_human(string_swap_used, swap_used, ctx->unit, ctx->decimals);
+    print_bytes_human(string_dirty, values[MEMINFO_DIRTY], ctx->unit, ctx->decimals);
+    print_bytes_human(string_writeback, values[MEMINFO_WRITEBACK], ctx->unit, ctx->decimals);
+    print_bytes_human(string_anon_huge_pages, values[MEMINFO_ANON_HUGE_PAGES], ctx->unit, ctx->decimals);
+    print_bytes_human(string_slab, values[MEMINFO_SLAB], ctx->unit, ctx->decimals);
+    print_bytes_human(string_committed_as, values[MEMINFO_COMMITTED_AS], ctx->unit, ctx->decimals);
     print_percentage(string_percentage_free, 100.0 * ram_free / ram_total);
     print_percentage(string_percentage_available, 100.0 * ram_available / ram_total);
     print_percentage(string_percentage_used, 100.0 * ram_used / ram_total);
@@ -195,6 +319,14 @@ void print_memory(memory_ctx_t *ctx) {
         {.name = "%free", .value = string_ram_free},
         {.name = "%available", .value = string_ram_available},
         {.name = "%shared", .value = string_ram_shared},
+        {.name = "%swap_total", .value = string_swap_total},
+        {.name = "%swap_free", .value = string_swap_free},
+        {.name = "%swap_used", .value = string_swap_used},
+        {.name = "%dirty", .value = string_dirty},
+        {.name = "%writeback", .value = string_writeback},
+        {.name = "%anon_huge_pages", .value = string_anon_huge_pages},
+        {.name = "%slab", .value = string_slab},
+        {.name = "%committed_as", .value = string_committed_as},
         {.name = "%percentage_free", .value = string_percentage_free},
         {.name = "%percentage_available", .value = string_percentage_available},
         {.name = "%percentage_used", .value = string_percentage_used},
@@ -10,11 +10,60 @@
 
 #define STRING_SIZE 5
 
+/*
+ * Whether a path exists is only checked again when file_watch() reports a
+ * change, so that watched paths cost nothing on an update.
+ *
+ */
+typedef struct {
+    char *path;
+    unsigned int changes;
+    unsigned int seen;
+    /* Whether exists is up to date as long as changes equals seen. */
+    bool valid;
+    bool exists;
+} path_state_t;
+
+/* Allocated one by one, as file_watch() keeps a pointer to their changes. */
+static path_state_t **paths = NULL;
+static int num_paths = 0;
+
+static path_state_t *path_state(const char *path) {
+    for (int i = 0; i < num_paths; i++) {
+        if (strcmp(paths[i]->path, path) == 0)
+            return paths[i];
+    }
+    path_state_t *state = scalloc(sizeof(path_state_t));
+    state->path = sstrdup(path);
+    paths = srealloc(paths, (num_paths + 1) * sizeof(path_state_t *));
+    paths[num_paths++] = state;
+    return state;
+}
+
+static bool path_exists(const char *path) {
+    if (path == NULL)
+        return false;
+
+    path_state_t *state = path_state(path);
+    const bool watched = file_watch(path, false, &state->changes);
+    if (state->valid && watched && state->seen == state->changes)
+        return state->exists;
+
+    state->seen = state->changes;
+    struct stat st;
+    state->exists = (lstat(path, &st) == 0);
+    /* The target of a symbolic link is not watched, so it is checked on
+     * every update. */
+    state->valid = !(state->exists && S_ISLNK(st.st_mode));
+    if (!state->valid)
+        state->exists = (stat(path, &st) == 0);
+    return state->exists;
+}
+
 void print_path_exists(path_exists_ctx_t *ctx) {
     const char *walk;
     char *outwalk = ctx->buf;
-    struct stat st;
-    const bool exists = (stat(ctx->path, &st) == 0);
+    const bool exists = path_exists(ctx->path);
 
     if (exists || ctx->format_down == NULL) {
         walk = ctx->format;
@@ -24,6 +73,10 @@ void print_path_exists(path_exists_ctx_t *ctx) {
 
     INSTANCE(ctx->path);
 
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, exists);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     START_COLOR((exists ? "color_good" : "color_bad"));
 
     char string_status[STRING_SIZE];
@@ -0,0 +1,54 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <yajl/yajl_gen.h>
+#include <yajl/yajl_version.h>
+#include "i3status.h"
+
+#define STRING_SIZE 12
+
+void print_process_watch(process_watch_ctx_t *ctx) {
+    const char *name = (ctx->name != NULL ? ctx->name : ctx->title);
+    const int count = process_count(name);
+    const bool running = (count > 0);
+    const char *walk;
+    char *outwalk = ctx->buf;
+
+    INSTANCE(name);
+
+    if (count == -1) {
+        OUTPUT_FULL_TEXT("can't list processes");
+        return;
+    }
+
+    if (running || ctx->format_down == NULL) {
+        walk = ctx->format;
+    } else {
+        walk = ctx->format_down;
+    }
+
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, count);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
+    START_COLOR((running ? "color_good" : "color_bad"));
+
+    char string_status[STRING_SIZE];
+    snprintf(string_status, STRING_SIZE, "%s", (running ? "yes" : "no"));
+    char string_count[STRING_SIZE];
+    format_int(string_count, count, 0, ' ');
+
+    placeholder_t placeholders[] = {
+        {.name = "%title", .value = ctx->title},
+        {.name = "%status", .value = string_status},
+        {.name = "%count", .value = string_count}};
+
+    const size_t num = sizeof(placeholders) / sizeof(placeholder_t);
+    char *formatted = format_placeholders(walk, &placeholders[0], num);
+    OUTPUT_FORMATTED;
+    free(formatted);
+    END_COLOR;
+    OUTPUT_FULL_TEXT(ctx->buf);
+}
@@ -22,6 +22,10 @@ void print_run_watch(run_watch_ctx_t *ctx) {
 
     INSTANCE(ctx->pidfile);
 
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    FINGERPRINT(fingerprint, running);
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
     START_COLOR((running ? "color_good" : "color_bad"));
 
     char string_status[STRING_SIZE];
@@ -34,6 +38,7 @@ void print_run_watch(run_watch_ctx_t *ctx) {
     const size_t num = sizeof(placeholders) / sizeof(placeholder_t);
     char *formatted = format_placeholders(walk, &placeholders[0], num);
     OUTPUT_FORMATTED;
+    free(formatted);
     END_COLOR;
     OUTPUT_FULL_TEXT(ctx->buf);
 }
@@ -0,0 +1,192 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <glob.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <yajl/yajl_gen.h>
+#include <yajl/yajl_version.h>
+
+#include "i3status.h"
+
+#define STRING_SIZE 32
+
+/* Sensors can appear and disappear (e.g. CPUs going offline), so the path is
+ * searched for them again after this many seconds. */
+#define SENSOR_RESCAN_INTERVAL 30
+
+/* More decimals than this are not shown. */
+#define SENSOR_MAX_DECIMALS 9
+
+/* Rounded values at or above this do not fit into a long long. */
+#define SENSOR_INT_LIMIT 9e18
+
+/*
+ * The files matching the path of a sensor block. They are searched for once
+ * and then kept open (see fd_cache_pread()), so that reading many of them only
+ * costs a pread() each.
+ *
+ */
+typedef struct {
+    char *path;
+    glob_t globbuf;
+    time_t scanned;
+    /* Set when a file could not be read. */
+    bool stale;
+} sensor_files_t;
+
+static sensor_files_t *sensor_files = NULL;
+static int num_sensor_files = 0;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static sensor_files_t *find_sensor_files(const char *path) {
+    sensor_files_t *files = NULL;
+    for (int i = 0; i < num_sensor_files; i++) {
+        if (strcmp(sensor_files[i].path, path) == 0) {
+            files = &sensor_files[i];
+            break;
+        }
+    }
+    if (files == NULL) {
+        sensor_files = srealloc(sensor_files, (num_sensor_files + 1) * sizeof(sensor_files_t));
+        files = &sensor_files[num_sensor_files++];
+        *files = (sensor_files_t){.path = sstrdup(path), .stale = true};
+    } else if (!files->stale && monotonic_seconds() - files->scanned < SENSOR_RESCAN_INTERVAL) {
+        return files;
+    } else {
+        globfree(&files->globbuf);
+    }
+
+    /* Unlike GLOB_NOCHECK, a path without matches yields no files. */
+    const int res = glob(path, GLOB_TILDE, NULL, &files->globbuf);
+    if (res != 0 && res != GLOB_NOMATCH)
+        die("glob() failed\n");
+    if (res == GLOB_NOMATCH)
+        files->globbuf.gl_pathc = 0;
+    files->scanned = monotonic_seconds();
+    files->stale = false;
+    return files;
+}
+
+/*
+ * Formats a value with the given number of decimals. Sensor files can contain
+ * any number, so values which do not fit into a long long (or are not finite)
+ * are left to format_fixed(), which bounds them by the buffer size.
+ *
+ */
+static void format_value(char *buf, double value, int decimals) {
+    if (decimals > SENSOR_MAX_DECIMALS)
+        decimals = SENSOR_MAX_DECIMALS;
+    if (decimals <= 0 && isfinite(value) && fabs(value) < SENSOR_INT_LIMIT)
+        format_int(buf, (long long)(value < 0 ? value - 0.5 : value + 0.5), 0, ' ');
+    else
+        format_fixed(buf, STRING_SIZE, value, decimals);
+}
+
+/*
+ * Reads a number from each of the files matching the path, scales it and
+ * aggregates the values.
+ *
+ */
+void print_sensor(sensor_ctx_t *ctx) {
+    const char *walk = ctx->format;
+    char *outwalk = ctx->buf;
+
+    if (ctx->path == NULL) {
+        OUTPUT_FULL_TEXT("error: path not configured");
+        return;
+    }
+
+    INSTANCE(ctx->path);
+
+    sensor_files_t *files = find_sensor_files(ctx->path);
+    int count = 0;
+    double min = 0, max = 0, sum = 0;
+    for (size_t i = 0; i < files->globbuf.gl_pathc; i++) {
+        char buf[64];
+        if (!slurp_cached(files->globbuf.gl_pathv[i], buf, sizeof(buf))) {
+            files->stale = true;
+            continue;
+        }
+        char *end;
+        const double raw = strtod(buf, &end);
+        if (end == buf)
+            continue;
+
+        const double value = raw * ctx->scale + ctx->offset;
+        if (count == 0 || value < min)
+            min = value;
+        if (count == 0 || value > max)
+            max = value;
+        sum += value;
+        count++;
+    }
+
+    if (count == 0) {
+        if (ctx->format_down == NULL) {
+            OUTPUT_FULL_TEXT("can't read sensor");
+            return;
+        }
+        walk = ctx->format_down;
+    }
+
+    const double avg = (count > 0 ? sum / count : 0);
+    double value = max;
+    if (strcasecmp(ctx->aggregate, "min") == 0)
+        value = min;
+    else if (strcasecmp(ctx->aggregate, "avg") == 0)
+        value = avg;
+    else if (strcasecmp(ctx->aggregate, "sum") == 0)
+        value = sum;
+
+    char string_value[STRING_SIZE], string_min[STRING_SIZE], string_max[STRING_SIZE];
+    char string_avg[STRING_SIZE], string_sum[STRING_SIZE], string_count[STRING_SIZE];
+    format_value(string_value, value, ctx->decimals);
+    format_value(string_min, min, ctx->decimals);
+    format_value(string_max, max, ctx->decimals);
+    format_value(string_avg, avg, ctx->decimals);
+    format_value(string_sum, sum, ctx->decimals);
+    format_int(string_count, count, 0, ' ');
+
+    const char *crossed = (count > 0 ? threshold_color(value, ctx->threshold_degraded, ctx->threshold_critical) : NULL);
+
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    fingerprint = fingerprint_str(fingerprint, string_value);
+    fingerprint = fingerprint_str(fingerprint, string_min);
+    fingerprint = fingerprint_str(fingerprint, string_max);
+    fingerprint = fingerprint_str(fingerprint, string_avg);
+    fingerprint = fingerprint_str(fingerprint, string_sum);
+    FINGERPRINT(fingerprint, count);
+    fingerprint = fingerprint_str(fingerprint, (crossed != NULL ? crossed : ""));
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
+    if (crossed != NULL) {
+        START_COLOR(crossed);
+    }
+
+    placeholder_t placeholders[] = {
+        {.name = "%title", .value = ctx->title},
+        {.name = "%value", .value = string_value},
+        {.name = "%min", .value = string_min},
+        {.name = "%max", .value = string_max},
+        {.name = "%avg", .value = string_avg},
+        {.name = "%sum", .value = string_sum},
+        {.name = "%count", .value = string_count}};
+
+    const size_t num = sizeof(placeholders) / sizeof(placeholder_t);
+    char *formatted = format_placeholders(walk, &placeholders[0], num);
+    OUTPUT_FORMATTED;
+    free(formatted);
+
+    if (crossed != NULL)
+        END_COLOR;
+    OUTPUT_FULL_TEXT(ctx->buf);
+}
@@ -53,7 +53,8 @@
 static char *apply_volume_format(const char *fmt, int ivolume, const char *devicename) {
     char string_volume[STRING_SIZE];
 
-    snprintf(string_volume, STRING_SIZE, "%d%s", ivolume, pct_mark);
+    char *walk = string_volume + format_int(string_volume, ivolume, 0, ' ');
+    stpcpy(walk, pct_mark);
 
     placeholder_t placeholders[] = {
         {.name = "%%", .value = pct_mark},
@@ -1,5 +1,6 @@
 // vim:ts=4:sw=4:expandtab
 #include <config.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -15,7 +16,15 @@
 #include <netlink/genl/ctrl.h>
 #include <linux/nl80211.h>
 #include <linux/if_ether.h>
+#include <time.h>
 #define IW_ESSID_MAX_SIZE 32
+
+/* While the kernel notifies about (dis)connections and signal changes, the
+ * link information is only queried again after this many seconds. */
+#define WIRELESS_POLL_INTERVAL 30
+
+/* The RSSI hysteresis (in dBm) for the connection quality monitor. */
+#define CQM_RSSI_HYSTERESIS 2
 #endif
 
 #ifdef __APPLE__
@@ -118,10 +127,48 @@ static void print_bitrate(char *buffer, int buflen, long int bitrate, const char
         scale = 'k';
         divisor = kilo;
     }
+    if (strcmp(format_bitrate, "%g %cb/s") == 0) {
+        /* The default format is handled without printf. */
+        char *walk = buffer + format_general(buffer, buflen, rate / divisor);
+        *(walk++) = ' ';
+        *(walk++) = scale;
+        strcpy(walk, "b/s");
+        return;
+    }
     snprintf(buffer, buflen, format_bitrate, rate / divisor, scale);
 }
 #endif
 
+/*
+ * Formats a percentage according to the given format, e.g. format_quality.
+ * Formats like the default "%3d%s" are handled without printf.
+ *
+ */
+static void print_percent(char *buffer, const char *format, int percent) {
+    if (format[0] == '%') {
+        const char pad = (format[1] == '0' ? '0' : ' ');
+        char *end;
+        long width = strtol(format + 1, &end, 10);
+        /* Wider formats are left to snprintf, which bounds them. */
+        if (isdigit((unsigned char)format[1]) && strcmp(end, "d%s") == 0 &&
+            width < (long)(STRING_SIZE - strlen(pct_mark) - 1)) {
+            buffer += format_int(buffer, percent, width, pad);
+            strcpy(buffer, pct_mark);
+            return;
+        }
+    }
+    snprintf(buffer, STRING_SIZE, format, percent, pct_mark);
+}
+
+/*
+ * Formats a level in dBm.
+ *
+ */
+static void print_dbm(char *buffer, int level) {
+    buffer += format_int(buffer, level, 0, ' ');
+    strcpy(buffer, " dBm");
+}
+
 #ifdef __linux__
 // Based on NetworkManager/src/platform/wifi/wifi-utils-nl80211.c
 static uint32_t nl80211_xbm_to_percent(int32_t xbm, int32_t divisor) {
@@ -284,39 +331,362 @@ static int gwi_scan_cb(struct nl_msg *msg, void *data) {
 
     return NL_SKIP;
 }
-#endif
 
-static int get_wireless_info(const char *interface, wireless_info_t *info) {
-    memset(info, 0, sizeof(wireless_info_t));
+static int gwi_iface_cb(struct nl_msg *msg, void *data) {
+    wireless_info_t *info = data;
+    struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+
+    if (nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL) < 0)
+        return NL_SKIP;
+
+    if (tb[NL80211_ATTR_SSID] != NULL && nla_len(tb[NL80211_ATTR_SSID]) > 0) {
+        info->flags |= WIRELESS_INFO_FLAG_HAS_ESSID;
+        snprintf(info->essid, sizeof(info->essid), "%.*s", nla_len(tb[NL80211_ATTR_SSID]), (char *)nla_data(tb[NL80211_ATTR_SSID]));
+    }
+
+    if (tb[NL80211_ATTR_WIPHY_FREQ] != NULL) {
+        info->flags |= WIRELESS_INFO_FLAG_HAS_FREQUENCY;
+        info->frequency = (double)nla_get_u32(tb[NL80211_ATTR_WIPHY_FREQ]) * 1e6;
+    }
+
+    return NL_SKIP;
+}
+#endif
 
 #ifdef __linux__
+/*
+ * The nl80211 socket and the id of the nl80211 family are shared by all
+ * wireless blocks and kept for the lifetime of the process, so that an update
+ * only costs the queries themselves. After an error, the socket is closed, as
+ * it might still hold replies, and connected again on the next update.
+ *
+ */
+static struct nl_sock *nl80211_sock = NULL;
+static int nl80211_id = -1;
+
+static struct nl_sock *nl80211_socket(void) {
+    if (nl80211_sock != NULL)
+        return nl80211_sock;
+
+    struct nl_sock *sk = nl_socket_alloc();
+    if (sk == NULL)
+        return NULL;
+    if (genl_connect(sk) != 0) {
+        nl_socket_free(sk);
+        return NULL;
+    }
+    const int id = genl_ctrl_resolve(sk, "nl80211");
+    if (id < 0) {
+        nl_socket_free(sk);
+        return NULL;
+    }
+    nl80211_sock = sk;
+    nl80211_id = id;
+    return sk;
+}
+
+static void nl80211_close(void) {
+    nl_socket_free(nl80211_sock);
+    nl80211_sock = NULL;
+    nl80211_id = -1;
+}
+
+typedef enum {
+    CQM_UNSET = 0,
+    CQM_SET,
+    CQM_UNSUPPORTED
+} cqm_state_t;
+
+/*
+ * The last link information of an interface. It is kept until nl80211
+ * announces a change of the connection or a signal threshold being crossed
+ * (see set_cqm()), or WIRELESS_POLL_INTERVAL passed. The ESSID, frequency and
+ * BSSID alone are kept until the interface (dis)connects, roams or switches
+ * channels.
+ *
+ */
+typedef struct {
+    char *interface;
+    bool with_scan;
+    unsigned int ifidx;
+    wireless_info_t info;
+    bool cached;
+    time_t queried;
+    wireless_info_t link;
+    bool link_cached;
+    cqm_state_t cqm;
+} wireless_state_t;
+
+static wireless_state_t *wireless_states = NULL;
+static int num_wireless_states = 0;
+
+/* The socket which receives the nl80211 "mlme" and "config" notifications,
+ * or NULL if they are not available. */
+static struct nl_sock *nl80211_events_sock = NULL;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static wireless_state_t *find_wireless_state(const char *interface, bool with_scan) {
+    for (int i = 0; i < num_wireless_states; i++) {
+        if (strcmp(wireless_states[i].interface, interface) == 0 && wireless_states[i].with_scan == with_scan)
+            return &wireless_states[i];
+    }
+    wireless_states = srealloc(wireless_states, (num_wireless_states + 1) * sizeof(wireless_state_t));
+    wireless_state_t *state = &wireless_states[num_wireless_states++];
+    *state = (wireless_state_t){.interface = sstrdup(interface), .with_scan = with_scan};
+    return state;
+}
+
+/*
+ * Forgets the link information of the given interface (or of all interfaces
+ * if ifidx is 0). The ESSID, frequency and BSSID are only forgotten if the
+ * link changed. If it (re)connected, the signal thresholds are set again.
+ *
+ */
+static void invalidate_wireless_states(unsigned int ifidx, bool link_changed, bool reconnected) {
+    for (int i = 0; i < num_wireless_states; i++) {
+        wireless_state_t *state = &wireless_states[i];
+        if (ifidx != 0 && state->ifidx != ifidx)
+            continue;
+        state->cached = false;
+        if (link_changed)
+            state->link_cached = false;
+        if (reconnected)
+            state->cqm = CQM_UNSET;
+    }
+}
+
+static int nl80211_event_cb(struct nl_msg *msg, void *data) {
+    bool *changed = data;
+    struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+
+    if (nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL) < 0)
+        return NL_SKIP;
+
+    bool link_changed = true, reconnected = false;
+    switch (gnlh->cmd) {
+        case NL80211_CMD_CONNECT:
+        case NL80211_CMD_ROAM:
+        case NL80211_CMD_JOIN_IBSS:
+        case NL80211_CMD_NEW_INTERFACE:
+        case NL80211_CMD_DEL_INTERFACE:
+        case NL80211_CMD_SET_INTERFACE:
+            reconnected = true;
+            break;
+        case NL80211_CMD_DISCONNECT:
+        case NL80211_CMD_LEAVE_IBSS:
+        case NL80211_CMD_CH_SWITCH_NOTIFY:
+            break;
+        case NL80211_CMD_NOTIFY_CQM:
+            link_changed = false;
+            break;
+        default:
+            return NL_SKIP;
+    }
+
+    const unsigned int ifidx = (tb[NL80211_ATTR_IFINDEX] != NULL ? nla_get_u32(tb[NL80211_ATTR_IFINDEX]) : 0);
+    invalidate_wireless_states(ifidx, link_changed, reconnected);
+    *changed = true;
+    return NL_SKIP;
+}
+
+static void close_nl80211_events(void) {
+    events_unwatch(nl_socket_get_fd(nl80211_events_sock));
+    nl_socket_free(nl80211_events_sock);
+    nl80211_events_sock = NULL;
+    invalidate_wireless_states(0, true, false);
+}
+
+static bool read_nl80211_events(int fd, void *data) {
+    bool changed = false;
+    if (nl_socket_modify_cb(nl80211_events_sock, NL_CB_VALID, NL_CB_CUSTOM, nl80211_event_cb, &changed) < 0) {
+        close_nl80211_events();
+        return true;
+    }
+
+    int err;
+    while ((err = nl_recvmsgs_default(nl80211_events_sock)) >= 0)
+        ;
+    if (err == -NLE_NOMEM) {
+        /* The receive buffer overflowed (ENOBUFS), so notifications were
+         * lost. */
+        invalidate_wireless_states(0, true, true);
+        return true;
+    }
+    if (err != -NLE_AGAIN) {
+        close_nl80211_events();
+        return true;
+    }
+    return changed;
+}
+
+/*
+ * Subscribes to the nl80211 multicast groups which announce connects,
+ * disconnects, roaming and signal threshold crossings. Returns false if they
+ * are not available, in which case the link information is queried on every
+ * update.
+ *
+ */
+static bool open_nl80211_events(void) {
+    static bool opened = false;
+    if (opened)
+        return (nl80211_events_sock != NULL);
+    opened = true;
+
     struct nl_sock *sk = nl_socket_alloc();
+    if (sk == NULL)
+        return false;
+    /* Notifications do not carry the sequence numbers of our requests. */
+    nl_socket_disable_seq_check(sk);
     if (genl_connect(sk) != 0)
-        goto error1;
+        goto error;
 
-    if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, gwi_scan_cb, info) < 0)
-        goto error1;
+    const char *groups[] = {"mlme", "config"};
+    for (size_t i = 0; i < sizeof(groups) / sizeof(groups[0]); i++) {
+        const int group = genl_ctrl_resolve_grp(sk, "nl80211", groups[i]);
+        if (group < 0 || nl_socket_add_membership(sk, group) < 0)
+            goto error;
+    }
+    if (nl_socket_set_nonblocking(sk) < 0)
+        goto error;
 
-    const int nl80211_id = genl_ctrl_resolve(sk, "nl80211");
-    if (nl80211_id < 0)
-        goto error1;
+    nl80211_events_sock = sk;
+    events_watch(nl_socket_get_fd(sk), read_nl80211_events, NULL);
+    return true;
+
+error:
+    nl_socket_free(sk);
+    return false;
+}
+
+static bool send_cqm(struct nl_sock *sk, unsigned int ifidx, const int32_t *thresholds, int num_thresholds) {
+    struct nl_msg *msg = nlmsg_alloc();
+    if (msg == NULL)
+        return false;
+
+    struct nlattr *cqm;
+    if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, nl80211_id, 0, 0, NL80211_CMD_SET_CQM, 0) ||
+        nla_put_u32(msg, NL80211_ATTR_IFINDEX, ifidx) < 0 ||
+        (cqm = nla_nest_start(msg, NL80211_ATTR_CQM)) == NULL ||
+        nla_put(msg, NL80211_ATTR_CQM_RSSI_THOLD, num_thresholds * sizeof(int32_t), thresholds) < 0 ||
+        nla_put_u32(msg, NL80211_ATTR_CQM_RSSI_HYST, CQM_RSSI_HYSTERESIS) < 0) {
+        nlmsg_free(msg);
+        return false;
+    }
+    nla_nest_end(msg, cqm);
+
+    // nl_send_sync calls nlmsg_free()
+    return (nl_send_sync(sk, msg) == 0);
+}
+
+/*
+ * Asks the kernel to notify about the signal crossing one of a few bands, so
+ * that it does not have to be polled. Drivers which only support a single
+ * threshold get the one at which the quality is colored as degraded. Setting
+ * thresholds needs CAP_NET_ADMIN.
+ *
+ */
+static bool set_cqm(struct nl_sock *sk, unsigned int ifidx) {
+    static const int32_t thresholds[] = {-80, -70, -60, -50};
+    return (send_cqm(sk, ifidx, thresholds, sizeof(thresholds) / sizeof(thresholds[0])) ||
+            send_cqm(sk, ifidx, &thresholds[1], 1));
+}
+#endif
+
+/*
+ * Gets the link information of the given interface. The ESSID and the
+ * frequency are only requested when with_scan is set. On Linux, they are
+ * taken from the interface and only looked up in the scan results, which
+ * are comparatively expensive to dump, if the kernel does not report them
+ * there.
+ *
+ * On Linux, the information is kept while nl80211 notifies about changes,
+ * unless with_bitrate is set: the bitrate changes without notification.
+ *
+ */
+static int get_wireless_info(const char *interface, wireless_info_t *info, bool with_scan, bool with_bitrate) {
+    memset(info, 0, sizeof(wireless_info_t));
 
+#ifdef __linux__
     const unsigned int ifidx = if_nametoindex(interface);
     if (ifidx == 0)
-        goto error1;
+        return 0;
 
-    struct nl_msg *msg = NULL;
-    if ((msg = nlmsg_alloc()) == NULL)
-        goto error1;
+    wireless_state_t *state = find_wireless_state(interface, with_scan);
+    if (state->ifidx != ifidx) {
+        state->ifidx = ifidx;
+        state->cached = false;
+        state->cqm = CQM_UNSET;
+    }
+    if (state->cached && nl80211_events_sock != NULL && monotonic_seconds() - state->queried < WIRELESS_POLL_INTERVAL) {
+        *info = state->info;
+        return 1;
+    }
+    state->cached = false;
 
-    if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, nl80211_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) ||
-        nla_put_u32(msg, NL80211_ATTR_IFINDEX, ifidx) < 0)
-        goto error2;
+    struct nl_sock *sk = nl80211_socket();
+    if (sk == NULL)
+        return 0;
 
-    if (nl_send_sync(sk, msg) < 0)
-        // nl_send_sync calls nlmsg_free()
-        goto error1;
-    msg = NULL;
+    struct nl_msg *msg = NULL;
+    if (with_scan && state->link_cached && nl80211_events_sock != NULL) {
+        *info = state->link;
+    } else if (with_scan) {
+        if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, gwi_iface_cb, info) < 0)
+            goto error1;
+
+        if ((msg = nlmsg_alloc()) == NULL)
+            goto error1;
+
+        if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, nl80211_id, 0, 0, NL80211_CMD_GET_INTERFACE, 0) ||
+            nla_put_u32(msg, NL80211_ATTR_IFINDEX, ifidx) < 0)
+            goto error2;
+
+        if (nl_send_sync(sk, msg) < 0)
+            // nl_send_sync calls nlmsg_free()
+            goto error1;
+        msg = NULL;
+
+        /* Older kernels do not report the SSID of the interface. Once
+         * one did, a missing SSID means that the interface is not connected. */
+        static bool interface_reports_ssid = false;
+        const int link_flags = WIRELESS_INFO_FLAG_HAS_ESSID | WIRELESS_INFO_FLAG_HAS_FREQUENCY;
+        if (info->flags & WIRELESS_INFO_FLAG_HAS_ESSID)
+            interface_reports_ssid = true;
+
+        if ((info->flags & link_flags) != link_flags &&
+            (!interface_reports_ssid || (info->flags & WIRELESS_INFO_FLAG_HAS_ESSID))) {
+            memset(info, 0, sizeof(wireless_info_t));
+
+            if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, gwi_scan_cb, info) < 0)
+                goto error1;
+
+            if ((msg = nlmsg_alloc()) == NULL)
+                goto error1;
+
+            if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, nl80211_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) ||
+                nla_put_u32(msg, NL80211_ATTR_IFINDEX, ifidx) < 0)
+                goto error2;
+
+            if (nl_send_sync(sk, msg) < 0)
+                // nl_send_sync calls nlmsg_free()
+                goto error1;
+            msg = NULL;
+        }
+
+        /* The signal from the scan results is not kept, the station
+         * information below is more recent. */
+        state->link = (wireless_info_t){.flags = info->flags & link_flags, .frequency = info->frequency};
+        memcpy(state->link.essid, info->essid, sizeof(info->essid));
+        memcpy(state->link.bssid, info->bssid, sizeof(info->bssid));
+        state->link_cached = true;
+    }
 
     if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, gwi_sta_cb, info) < 0)
         goto error1;
@@ -324,7 +694,11 @@ static int get_wireless_info(const char *interface, wireless_info_t *info) {
     if ((msg = nlmsg_alloc()) == NULL)
         goto error1;
 
-    if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, nl80211_id, 0, NLM_F_DUMP, NL80211_CMD_GET_STATION, 0) || nla_put_u32(msg, NL80211_ATTR_IFINDEX, ifidx) < 0 || nla_put(msg, NL80211_ATTR_MAC, 6, info->bssid) < 0)
+    /* The BSSID is only known from the scan results. On a managed interface,
+     * the only station is the access point anyway. */
+    static const uint8_t no_bssid[ETH_ALEN];
+    const bool with_bssid = (memcmp(info->bssid, no_bssid, ETH_ALEN) != 0);
+    if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, nl80211_id, 0, NLM_F_DUMP, NL80211_CMD_GET_STATION, 0) || nla_put_u32(msg, NL80211_ATTR_IFINDEX, ifidx) < 0 || (with_bssid && nla_put(msg, NL80211_ATTR_MAC, 6, info->bssid) < 0))
         goto error2;
 
     if (nl_send_sync(sk, msg) < 0)
@@ -332,13 +706,19 @@ static int get_wireless_info(const char *interface, wireless_info_t *info) {
         goto error1;
     msg = NULL;
 
-    nl_socket_free(sk);
+    if (open_nl80211_events() && state->cqm == CQM_UNSET)
+        state->cqm = (set_cqm(sk, ifidx) ? CQM_SET : CQM_UNSUPPORTED);
+    if (!with_bitrate && state->cqm == CQM_SET) {
+        state->info = *info;
+        state->queried = monotonic_seconds();
+        state->cached = true;
+    }
     return 1;
 
 error2:
     nlmsg_free(msg);
 error1:
-    nl_socket_free(sk);
+    nl80211_close();
     return 0;
 
 #endif
@@ -518,7 +898,11 @@ void print_wireless_info(wireless_info_ctx_t *ctx) {
     INSTANCE(ctx->interface);
 
     char *ipv4_address = sstrdup(get_ip_addr(ctx->interface, AF_INET));
-    char *ipv6_address = sstrdup(get_ip_addr(ctx->interface, AF_INET6));
+    /* The IPv6 address is only displayed (and only decides whether the
+     * interface is up) when there is no IPv4 address. */
+    char *ipv6_address = NULL;
+    if (ipv4_address == NULL || BEGINS_WITH(ipv4_address, "no IP"))
+        ipv6_address = sstrdup(get_ip_addr(ctx->interface, AF_INET6));
 
     /*
      * Removing '%' and following characters from IPv6 since the interface identifier is redundant,
@@ -549,8 +933,36 @@ void print_wireless_info(wireless_info_ctx_t *ctx) {
         prefer_ipv4 = false;
     }
 
-    const char *ip_address = (prefer_ipv4) ? ipv4_address : ipv6_address;
-    if (!get_wireless_info(ctx->interface, &info)) {
+    char string_ip[STRING_SIZE] = {'\0'};
+    snprintf(string_ip, STRING_SIZE, "%s", (prefer_ipv4) ? ipv4_address : ipv6_address);
+    free(ipv4_address);
+    free(ipv6_address);
+
+    const bool with_scan = FORMATS_USE("%essid", ctx->format_up, ctx->format_down) ||
+                           FORMATS_USE("%frequency", ctx->format_up, ctx->format_down);
+    const bool with_bitrate = FORMATS_USE("%bitrate", ctx->format_up, ctx->format_down);
+    const bool connected = get_wireless_info(ctx->interface, &info, with_scan, with_bitrate);
+
+    uint64_t fingerprint = FINGERPRINT_INIT;
+    fingerprint = fingerprint_str(fingerprint, string_ip);
+    fingerprint = fingerprint_str(fingerprint, ctx->interface);
+    FINGERPRINT(fingerprint, connected);
+    FINGERPRINT(fingerprint, info.flags);
+    FINGERPRINT(fingerprint, info.quality);
+    FINGERPRINT(fingerprint, info.quality_max);
+    FINGERPRINT(fingerprint, info.quality_average);
+    FINGERPRINT(fingerprint, info.signal_level);
+    FINGERPRINT(fingerprint, info.signal_level_max);
+    FINGERPRINT(fingerprint, info.noise_level);
+    FINGERPRINT(fingerprint, info.noise_level_max);
+    FINGERPRINT(fingerprint, info.bitrate);
+    FINGERPRINT(fingerprint, info.frequency);
+#ifdef IW_ESSID_MAX_SIZE
+    fingerprint = fingerprint_str(fingerprint, info.essid);
+#endif
+    RETURN_IF_RENDER_CACHED(fingerprint);
+
+    if (!connected) {
         walk = ctx->format_down;
         START_COLOR("color_bad");
     } else {
@@ -558,7 +970,7 @@ void print_wireless_info(wireless_info_ctx_t *ctx) {
         if (info.flags & WIRELESS_INFO_FLAG_HAS_QUALITY)
             START_COLOR((info.quality < info.quality_average ? "color_degraded" : "color_good"));
         else {
-            if (BEGINS_WITH(ip_address, "no IP")) {
+            if (BEGINS_WITH(string_ip, "no IP")) {
                 START_COLOR("color_degraded");
             } else {
                 START_COLOR("color_good");
@@ -571,32 +983,31 @@ void print_wireless_info(wireless_info_ctx_t *ctx) {
     char string_noise[STRING_SIZE] = {'\0'};
     char string_essid[STRING_SIZE] = {'\0'};
     char string_frequency[STRING_SIZE] = {'\0'};
-    char string_ip[STRING_SIZE] = {'\0'};
     char string_bitrate[STRING_SIZE] = {'\0'};
 
     if (info.flags & WIRELESS_INFO_FLAG_HAS_QUALITY) {
         if (info.quality_max)
-            snprintf(string_quality, STRING_SIZE, ctx->format_quality, PERCENT_VALUE(info.quality, info.quality_max), pct_mark);
+            print_percent(string_quality, ctx->format_quality, PERCENT_VALUE(info.quality, info.quality_max));
         else
-            snprintf(string_quality, STRING_SIZE, "%d", info.quality);
+            format_int(string_quality, info.quality, 0, ' ');
     } else {
         snprintf(string_quality, STRING_SIZE, "?");
     }
 
     if (info.flags & WIRELESS_INFO_FLAG_HAS_SIGNAL) {
         if (info.signal_level_max)
-            snprintf(string_signal, STRING_SIZE, ctx->format_signal, PERCENT_VALUE(info.signal_level, info.signal_level_max), pct_mark);
+            print_percent(string_signal, ctx->format_signal, PERCENT_VALUE(info.signal_level, info.signal_level_max));
         else
-            snprintf(string_signal, STRING_SIZE, "%d dBm", info.signal_level);
+            print_dbm(string_signal, info.signal_level);
     } else {
         snprintf(string_signal, STRING_SIZE, "?");
     }
 
     if (info.flags & WIRELESS_INFO_FLAG_HAS_NOISE) {
         if (info.noise_level_max)
-            snprintf(string_noise, STRING_SIZE, ctx->format_noise, PERCENT_VALUE(info.noise_level, info.noise_level_max), pct_mark);
+            print_percent(string_noise, ctx->format_noise, PERCENT_VALUE(info.noise_level, info.noise_level_max));
         else
-            snprintf(string_noise, STRING_SIZE, "%d dBm", info.noise_level);
+            print_dbm(string_noise, info.noise_level);
     } else {
         snprintf(string_noise, STRING_SIZE, "?");
     }
@@ -608,13 +1019,12 @@ void print_wireless_info(wireless_info_ctx_t *ctx) {
 #endif
         snprintf(string_essid, STRING_SIZE, "?");
 
-    if (info.flags & WIRELESS_INFO_FLAG_HAS_FREQUENCY)
-        snprintf(string_frequency, STRING_SIZE, "%1.1f GHz", info.frequency / 1e9);
-    else
+    if (info.flags & WIRELESS_INFO_FLAG_HAS_FREQUENCY) {
+        char *walk = string_frequency + format_fixed(string_frequency, sizeof(string_frequency), info.frequency / 1e9, 1);
+        strcpy(walk, " GHz");
+    } else
         snprintf(string_frequency, STRING_SIZE, "?");
 
-    snprintf(string_ip, STRING_SIZE, "%s", ip_address);
-
 #if defined(__linux__) || defined(__FreeBSD__)
     print_bitrate(string_bitrate, sizeof(string_bitrate), info.bitrate, ctx->format_bitrate);
 #endif
@@ -634,7 +1044,5 @@ void print_wireless_info(wireless_info_ctx_t *ctx) {
     free(formatted);
 
     END_COLOR;
-    free(ipv4_address);
-    free(ipv6_address);
     OUTPUT_FULL_TEXT(ctx->buf);
 }
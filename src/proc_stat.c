@@ -0,0 +1,271 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "i3status.h"
+
+#if defined(__linux__)
+/* The snapshot of the current and of the previous tick. The current one is
+ * snapshots[current]. */
+static proc_stat_t snapshots[2];
+static int current = 0;
+static bool have_current = false;
+static bool have_previous = false;
+
+static char *snapshot_path = NULL;
+static uint64_t snapshot_tick = 0;
+static bool snapshot_failed = false;
+static const char *snapshot_text = NULL;
+
+/*
+ * Reads the whole statistics file into a buffer which grows as needed and is
+ * reused on the next call. Returns NULL if the file cannot be read.
+ *
+ */
+static const char *read_stat(const char *path) {
+    static char *buf = NULL;
+    static size_t size = 4096;
+    if (buf == NULL)
+        buf = scalloc(size);
+
+    while (true) {
+        bool opened;
+        ssize_t n = fd_cache_pread(path, buf, size - 1, &opened);
+        if (n == -1) {
+            fprintf(stderr, "i3status: %s %s: %s\n", (opened ? "read" : "open"), path, strerror(errno));
+            return NULL;
+        }
+        if ((size_t)n < size - 1) {
+            buf[n] = '\0';
+            return buf;
+        }
+        size *= 2;
+        buf = srealloc(buf, size);
+    }
+}
+
+/*
+ * Parses the decimal number at *walk and advances *walk past it. This is
+ * called for every column of every CPU, so it avoids the overhead of
+ * strtoull() (locale, sign and base handling).
+ *
+ */
+static bool parse_number(const char **walk, unsigned long long *value) {
+    const char *digit = *walk;
+    while (*digit == ' ')
+        digit++;
+    if (*digit < '0' || *digit > '9')
+        return false;
+
+    unsigned long long result = 0;
+    for (; *digit >= '0' && *digit <= '9'; digit++)
+        result = result * 10 + (*digit - '0');
+    *value = result;
+    *walk = digit;
+    return true;
+}
+
+/*
+ * Parses the columns of a cpu line, starting after the CPU number, and
+ * returns a pointer to the end of the parsed columns or NULL on error. At
+ * least the first four columns are required, older kernels do not have all
+ * of them.
+ *
+ */
+static const char *parse_cpu_times(const char *walk, cpu_times_t *times) {
+    unsigned long long *const columns[] = {
+        &times->user, &times->nice, &times->system, &times->idle, &times->iowait,
+        &times->irq, &times->softirq, &times->steal, &times->guest, &times->guest_nice};
+    const int num_columns = sizeof(columns) / sizeof(*columns);
+
+    int column;
+    for (column = 0; column < num_columns; column++) {
+        if (!parse_number(&walk, columns[column]))
+            break;
+    }
+    if (column < 4)
+        return NULL;
+    for (; column < num_columns; column++)
+        *columns[column] = 0;
+    return walk;
+}
+
+/*
+ * Returns the per-CPU times of the given CPU, growing the arrays as needed.
+ * They only grow when a CPU with a higher number shows up, so parsing does
+ * not allocate in the steady state.
+ *
+ */
+static cpu_times_t *cpu_slot(proc_stat_t *stat, int cpu) {
+    if (cpu >= stat->cpus_size) {
+        const int size = cpu + 1;
+        stat->cpus = srealloc(stat->cpus, size * sizeof(cpu_times_t));
+        stat->online = srealloc(stat->online, size * sizeof(bool));
+        memset(stat->cpus + stat->cpus_size, 0, (size - stat->cpus_size) * sizeof(cpu_times_t));
+        memset(stat->online + stat->cpus_size, 0, (size - stat->cpus_size) * sizeof(bool));
+        stat->cpus_size = size;
+    }
+    return &stat->cpus[cpu];
+}
+
+/*
+ * Marks the CPUs from first to last (exclusive) as offline. They keep the
+ * last times they had while online, so that the sum over all CPUs does not
+ * drop when a CPU is unplugged.
+ *
+ */
+static void keep_offline_cpus(proc_stat_t *stat, const proc_stat_t *previous, int first, int last) {
+    for (int cpu = first; cpu < last; cpu++) {
+        if (previous != NULL && cpu < previous->cpus_size) {
+            *cpu_slot(stat, cpu) = previous->cpus[cpu];
+        } else if (cpu < stat->cpus_size) {
+            memset(&stat->cpus[cpu], 0, sizeof(cpu_times_t));
+        } else {
+            continue;
+        }
+        stat->online[cpu] = false;
+    }
+}
+
+/*
+ * Parses the contents of /proc/stat into the given snapshot. The per-CPU
+ * lines are only parsed if per_cpu is set. CPUs which have no line (because
+ * they are offline) keep their times of the previous snapshot.
+ *
+ */
+static bool parse_stat(const char *text, proc_stat_t *stat, const proc_stat_t *previous, bool per_cpu) {
+    if (!BEGINS_WITH(text, "cpu ") || parse_cpu_times(text + strlen("cpu"), &stat->all) == NULL)
+        return false;
+
+    if (previous != NULL && !previous->has_cpus)
+        previous = NULL;
+    stat->has_cpus = per_cpu;
+    stat->num_cpus = 0;
+    int next_cpu = 0;
+    for (const char *line = text; (line = strchr(line, '\n')) != NULL;) {
+        line++;
+        if (BEGINS_WITH(line, "cpu")) {
+            if (!per_cpu)
+                continue;
+            const char *walk = line + strlen("cpu");
+            unsigned long long cpu;
+            if (*walk == ' ' || !parse_number(&walk, &cpu) || cpu >= INT_MAX)
+                return false;
+            keep_offline_cpus(stat, previous, next_cpu, cpu);
+            if ((line = parse_cpu_times(walk, cpu_slot(stat, cpu))) == NULL)
+                return false;
+            stat->online[cpu] = true;
+            next_cpu = cpu + 1;
+            stat->num_cpus++;
+        } else if (BEGINS_WITH(line, "ctxt ")) {
+            stat->ctxt = strtoull(line + strlen("ctxt "), NULL, 10);
+        } else if (BEGINS_WITH(line, "processes ")) {
+            stat->processes = strtoull(line + strlen("processes "), NULL, 10);
+        } else if (BEGINS_WITH(line, "procs_running ")) {
+            stat->procs_running = strtoull(line + strlen("procs_running "), NULL, 10);
+        } else if (BEGINS_WITH(line, "procs_blocked ")) {
+            stat->procs_blocked = strtoull(line + strlen("procs_blocked "), NULL, 10);
+        }
+    }
+
+    if (per_cpu) {
+        int last_cpu = stat->cpus_size;
+        if (previous != NULL && previous->cpus_size > last_cpu)
+            last_cpu = previous->cpus_size;
+        keep_offline_cpus(stat, previous, next_cpu, last_cpu);
+
+        /* Like the aggregated line, "all" is the sum over all CPUs. */
+        memset(&stat->all, 0, sizeof(cpu_times_t));
+        for (int cpu = 0; cpu < stat->cpus_size; cpu++) {
+            const cpu_times_t *times = &stat->cpus[cpu];
+            stat->all.user += times->user;
+            stat->all.nice += times->nice;
+            stat->all.system += times->system;
+            stat->all.idle += times->idle;
+            stat->all.iowait += times->iowait;
+            stat->all.irq += times->irq;
+            stat->all.softirq += times->softirq;
+            stat->all.steal += times->steal;
+            stat->all.guest += times->guest;
+            stat->all.guest_nice += times->guest_nice;
+        }
+    }
+    return true;
+}
+#endif
+
+/*
+ * Returns the snapshot of the given statistics file (/proc/stat) for the
+ * current tick, reading it only once per tick no matter how many instances
+ * ask for it. previous is set to the snapshot of the previous tick, or NULL
+ * if there is none yet.
+ *
+ * The per-CPU times are only parsed if per_cpu is set. Returns NULL if the
+ * file cannot be read or parsed.
+ *
+ */
+const proc_stat_t *proc_stat_snapshot(const char *path, bool per_cpu, const proc_stat_t **previous) {
+#if defined(__linux__)
+    if (snapshot_path == NULL || strcmp(snapshot_path, path) != 0) {
+        free(snapshot_path);
+        snapshot_path = sstrdup(path);
+        have_current = have_previous = false;
+        snapshot_tick = tick - 1;
+    }
+
+    proc_stat_t *prev = (have_previous ? &snapshots[!current] : NULL);
+    if (snapshot_tick != tick) {
+        snapshot_tick = tick;
+        snapshot_text = read_stat(path);
+
+        proc_stat_t *next = &snapshots[have_current ? !current : current];
+        const proc_stat_t *last = (have_current ? &snapshots[current] : NULL);
+        snapshot_failed = (snapshot_text == NULL || !parse_stat(snapshot_text, next, last, per_cpu));
+        if (!snapshot_failed) {
+            clock_gettime(CLOCK_MONOTONIC, &next->time);
+            if (have_current)
+                current = !current;
+            have_previous = have_current;
+            have_current = true;
+            prev = (have_previous ? &snapshots[!current] : NULL);
+        }
+    } else if (!snapshot_failed && per_cpu && !snapshots[current].has_cpus) {
+        /* An earlier instance did not need the per-CPU lines. */
+        struct timespec time = snapshots[current].time;
+        snapshot_failed = !parse_stat(snapshot_text, &snapshots[current], prev, true);
+        snapshots[current].time = time;
+    }
+
+    if (snapshot_failed)
+        return NULL;
+    *previous = prev;
+    return &snapshots[current];
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * Returns the total time of all states. Guest time is not added as it is
+ * included in the user time already.
+ *
+ */
+unsigned long long cpu_times_total(const cpu_times_t *times) {
+    return times->user + times->nice + times->system + times->idle + times->iowait +
+           times->irq + times->softirq + times->steal;
+}
+
+/*
+ * Returns the time in which the CPU did not do anything, including the time
+ * spent waiting for I/O.
+ *
+ */
+unsigned long long cpu_times_idle(const cpu_times_t *times) {
+    return times->idle + times->iowait;
+}
@@ -0,0 +1,358 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#endif
+
+#include "i3status.h"
+
+#if defined(__linux__)
+/*
+ * Counts the processes by name (as in /proc/<pid>/comm). /proc is scanned
+ * once for every name which is asked for, afterwards the counts are updated
+ * incrementally: from the fork, exec, exit and comm events of the kernel's
+ * process connector, or, when that is not available (it requires
+ * CAP_NET_ADMIN), from the PIDs which appeared in or disappeared from /proc
+ * since the last update.
+ *
+ */
+typedef struct {
+    char *name;
+    int count;
+} process_name_t;
+
+/* A process which is counted for one of the names. */
+typedef struct {
+    pid_t pid;
+    int name;
+} counted_process_t;
+
+static process_name_t *names = NULL;
+static int num_names = 0;
+
+static counted_process_t *counted = NULL;
+static int num_counted = 0;
+
+/* The process connector socket, -1 while polling. */
+static int connector_fd = -1;
+
+/* While polling, the PIDs which were in /proc on the last update, sorted. */
+static pid_t *known_pids = NULL;
+static int num_known_pids = 0;
+static uint64_t polled_tick = 0;
+
+/*
+ * Reads the name of the given process. Returns false if the process does not
+ * exist (anymore).
+ *
+ */
+static bool read_comm(pid_t pid, char *comm, int size) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+    if (!slurp(path, comm, size))
+        return false;
+    comm[strcspn(comm, "\n")] = '\0';
+    return true;
+}
+
+static int find_name(const char *comm) {
+    for (int i = 0; i < num_names; i++) {
+        if (strcmp(names[i].name, comm) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static counted_process_t *find_counted(pid_t pid) {
+    for (int i = 0; i < num_counted; i++) {
+        if (counted[i].pid == pid)
+            return &counted[i];
+    }
+    return NULL;
+}
+
+/*
+ * Counts the process under the given name (or no name, if name is -1),
+ * moving it from the name it was counted under before. Returns whether a
+ * count changed.
+ *
+ */
+static bool count_process(pid_t pid, int name) {
+    counted_process_t *process = find_counted(pid);
+    if (process != NULL && process->name == name)
+        return false;
+    if (process == NULL && name == -1)
+        return false;
+
+    if (process != NULL) {
+        names[process->name].count--;
+        *process = counted[--num_counted];
+    }
+    if (name != -1) {
+        counted = srealloc(counted, (num_counted + 1) * sizeof(counted_process_t));
+        counted[num_counted++] = (counted_process_t){.pid = pid, .name = name};
+        names[name].count++;
+    }
+    return true;
+}
+
+/*
+ * A process was started or replaced its program: its name is read again.
+ *
+ */
+static bool process_execed(pid_t pid) {
+    char comm[64];
+    if (!read_comm(pid, comm, sizeof(comm)))
+        return count_process(pid, -1);
+    return count_process(pid, find_name(comm));
+}
+
+static bool process_forked(pid_t parent, pid_t child) {
+    /* The child has the name of its parent. */
+    counted_process_t *process = find_counted(parent);
+    return (process != NULL && count_process(child, process->name));
+}
+
+static int compare_pids(const void *a, const void *b) {
+    const pid_t pa = *(const pid_t *)a, pb = *(const pid_t *)b;
+    return (pa > pb) - (pa < pb);
+}
+
+/*
+ * Lists the PIDs in /proc, sorted. Returns -1 if /proc cannot be read.
+ *
+ */
+static int list_pids(pid_t **pids) {
+    DIR *dir = opendir("/proc");
+    if (dir == NULL)
+        return -1;
+
+    int num = 0, size = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9')
+            continue;
+        if (num == size) {
+            size = (size == 0 ? 512 : size * 2);
+            *pids = srealloc(*pids, size * sizeof(pid_t));
+        }
+        (*pids)[num++] = strtol(entry->d_name, NULL, 10);
+    }
+    closedir(dir);
+    qsort(*pids, num, sizeof(pid_t), compare_pids);
+    return num;
+}
+
+/*
+ * Counts the processes with the given name, which is new.
+ *
+ */
+static bool scan_name(int name) {
+    pid_t *pids = NULL;
+    int num = list_pids(&pids);
+    if (num == -1)
+        return false;
+
+    char comm[64];
+    for (int i = 0; i < num; i++) {
+        if (read_comm(pids[i], comm, sizeof(comm)) && strcmp(comm, names[name].name) == 0)
+            count_process(pids[i], name);
+    }
+    free(pids);
+    return true;
+}
+
+/*
+ * Updates the counts from the PIDs which appeared in or disappeared from
+ * /proc since the last update. Processes which are counted are checked
+ * again, as they might have executed another program.
+ *
+ */
+static bool poll_processes(void) {
+    pid_t *pids = NULL;
+    int num = list_pids(&pids);
+    if (num == -1)
+        return false;
+
+    int old = 0, new = 0;
+    while (old < num_known_pids || new < num) {
+        if (new == num || (old < num_known_pids && known_pids[old] < pids[new])) {
+            count_process(known_pids[old++], -1);
+        } else if (old == num_known_pids || pids[new] < known_pids[old]) {
+            process_execed(pids[new++]);
+        } else {
+            old++;
+            new++;
+        }
+    }
+    /* Going backwards, as a process which is not counted anymore is
+     * replaced by the last one. */
+    for (int i = num_counted - 1; i >= 0; i--)
+        process_execed(counted[i].pid);
+
+    free(known_pids);
+    known_pids = pids;
+    num_known_pids = num;
+    return true;
+}
+
+/*
+ * Reads the pending events of the process connector. Returns whether a count
+ * changed.
+ *
+ */
+static bool read_proc_events(int fd, void *data) {
+    char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    bool changed = false;
+    while (true) {
+        struct sockaddr_nl sender;
+        socklen_t sender_len = sizeof(sender);
+        ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&sender, &sender_len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ENOBUFS) {
+                /* Events were dropped, so the counts are rebuilt. */
+                num_counted = 0;
+                for (int i = 0; i < num_names; i++) {
+                    names[i].count = 0;
+                    scan_name(i);
+                }
+                changed = true;
+                continue;
+            }
+            return changed;
+        }
+        /* Only the kernel is trusted to report processes. */
+        if (sender.nl_pid != 0)
+            continue;
+
+        for (struct nlmsghdr *hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, n); hdr = NLMSG_NEXT(hdr, n)) {
+            const struct cn_msg *msg = NLMSG_DATA(hdr);
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC)
+                continue;
+            const struct proc_event *event = (const struct proc_event *)msg->data;
+            switch (event->what) {
+                case PROC_EVENT_NONE:
+                    /* The answer to PROC_CN_MCAST_LISTEN: without
+                     * CAP_NET_ADMIN, the kernel refuses to send events. */
+                    if (event->event_data.ack.err != 0) {
+                        events_unwatch(fd);
+                        (void)close(fd);
+                        connector_fd = -1;
+                        return changed;
+                    }
+                    break;
+                case PROC_EVENT_FORK:
+                    if (event->event_data.fork.child_pid == event->event_data.fork.child_tgid)
+                        changed |= process_forked(event->event_data.fork.parent_tgid, event->event_data.fork.child_tgid);
+                    break;
+                case PROC_EVENT_EXEC:
+                    changed |= process_execed(event->event_data.exec.process_tgid);
+                    break;
+                case PROC_EVENT_COMM:
+                    if (event->event_data.comm.process_pid == event->event_data.comm.process_tgid)
+                        changed |= count_process(event->event_data.comm.process_tgid, find_name(event->event_data.comm.comm));
+                    break;
+                case PROC_EVENT_EXIT:
+                    if (event->event_data.exit.process_pid == event->event_data.exit.process_tgid)
+                        changed |= count_process(event->event_data.exit.process_tgid, -1);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+/*
+ * Subscribes to the process connector. Returns false if it is not available.
+ *
+ */
+static bool open_connector(void) {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd == -1)
+        return false;
+    struct sockaddr_nl addr = {.nl_family = AF_NETLINK, .nl_groups = CN_IDX_PROC};
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        (void)close(fd);
+        return false;
+    }
+
+    char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))] __attribute__((aligned(NLMSG_ALIGNTO)));
+    memset(buf, 0, sizeof(buf));
+    struct nlmsghdr *hdr = (struct nlmsghdr *)buf;
+    hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    hdr->nlmsg_type = NLMSG_DONE;
+    struct cn_msg *msg = NLMSG_DATA(hdr);
+    msg->id.idx = CN_IDX_PROC;
+    msg->id.val = CN_VAL_PROC;
+    msg->len = sizeof(enum proc_cn_mcast_op);
+    const enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    memcpy(msg->data, &op, sizeof(op));
+    if (send(fd, buf, hdr->nlmsg_len, 0) == -1) {
+        (void)close(fd);
+        return false;
+    }
+
+    connector_fd = fd;
+    events_watch(fd, read_proc_events, NULL);
+    return true;
+}
+#endif
+
+/*
+ * Returns the number of processes with the given name, or -1 if processes
+ * cannot be listed.
+ *
+ */
+int process_count(const char *name) {
+#if defined(__linux__)
+    static bool subscribed = false;
+    if (!subscribed) {
+        subscribed = true;
+        /* Subscribe before scanning, so that no process gets lost. */
+        open_connector();
+    }
+
+    /* The kernel truncates process names to 15 characters. */
+    char comm[16];
+    snprintf(comm, sizeof(comm), "%s", name);
+
+    int index = find_name(comm);
+    if (index == -1) {
+        names = srealloc(names, (num_names + 1) * sizeof(process_name_t));
+        index = num_names++;
+        names[index] = (process_name_t){.name = sstrdup(comm), .count = 0};
+        if (!scan_name(index))
+            return -1;
+    }
+
+    if (connector_fd == -1 && polled_tick != tick) {
+        /* The first poll only notes which PIDs exist. */
+        bool first = (known_pids == NULL);
+        polled_tick = tick;
+        if (first) {
+            num_known_pids = list_pids(&known_pids);
+            if (num_known_pids == -1)
+                return -1;
+        } else if (!poll_processes()) {
+            return -1;
+        }
+    }
+    return names[index].count;
+#else
+    return -1;
+#endif
+}
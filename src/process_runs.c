@@ -8,19 +8,89 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <signal.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "i3status.h"
 
+#if defined(__linux__)
+/*
+ * On Linux, the result of process_runs() is kept until it changes: the
+ * pidfiles are watched (see file_watch()), and the process which was found
+ * running is watched through a pidfd, which becomes readable when the process
+ * exits. In between, checking costs nothing.
+ *
+ */
+typedef struct {
+    char *path;
+    /* The path with the tilde expanded, as watched. */
+    char *resolved;
+    /* Counted by file_watch(), and the count when the pidfiles were read. */
+    unsigned int changes;
+    unsigned int seen;
+    /* The pidfd of the running process which was found, -1 if none. */
+    int pidfd;
+    /* Whether running is up to date. */
+    bool valid;
+    bool running;
+} pidfile_watch_t;
+
+/* The watches are allocated one by one, as file_watch() keeps a pointer to
+ * their changes. */
+static pidfile_watch_t **watches = NULL;
+static int num_watches = 0;
+
+static int open_pidfd(pid_t pid) {
+#if defined(SYS_pidfd_open)
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+#endif
+
 /*
  * Checks if the PID in path is still valid by sending signal 0 (does not do
  * anything). kill() will return ESRCH if the process does not exist and 0 or
  * EPERM (depending on the uid) if it exists.
  *
+ * When pidfd is not NULL and the kernel supports it, a pidfd of the running
+ * process is opened instead, which checks whether the process exists as well.
+ * Unlike kill(), this does not count processes which exited already but were
+ * not reaped yet (zombies) as running.
+ *
+ */
+static bool pid_runs(const char *pidbuf, int *pidfd) {
+    const pid_t pid = strtol(pidbuf, NULL, 10);
+#if defined(__linux__)
+    if (pidfd != NULL && pid > 0) {
+        if ((*pidfd = open_pidfd(pid)) != -1) {
+            /* The pidfd of a process which exited but was not reaped by its
+             * parent yet is readable right away. */
+            struct pollfd exited = {.fd = *pidfd, .events = POLLIN};
+            if (poll(&exited, 1, 0) != 1)
+                return true;
+            (void)close(*pidfd);
+            *pidfd = -1;
+            return false;
+        }
+        if (errno == ESRCH)
+            return false;
+    }
+#endif
+    return (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/*
  * If multiple files match the glob pattern, all of them will be checked until
  * the first running process is found.
  *
  */
-bool process_runs(const char *path) {
+static bool check_pidfiles(const char *path, int *pidfd) {
     static char pidbuf[16];
     static glob_t globbuf;
     memset(pidbuf, 0, sizeof(pidbuf));
@@ -32,14 +102,14 @@ bool process_runs(const char *path) {
         globfree(&globbuf);
         if (!slurp(path, pidbuf, sizeof(pidbuf)))
             return false;
-        return (kill(strtol(pidbuf, NULL, 10), 0) == 0 || errno == EPERM);
+        return pid_runs(pidbuf, pidfd);
     }
     for (size_t i = 0; i < globbuf.gl_pathc; i++) {
         if (!slurp(globbuf.gl_pathv[i], pidbuf, sizeof(pidbuf))) {
             globfree(&globbuf);
             return false;
         }
-        if (kill(strtol(pidbuf, NULL, 10), 0) == 0 || errno == EPERM) {
+        if (pid_runs(pidbuf, pidfd)) {
             globfree(&globbuf);
             return true;
         }
@@ -48,3 +118,65 @@ bool process_runs(const char *path) {
 
     return false;
 }
+
+#if defined(__linux__)
+/*
+ * Called when the process of a pidfd exited.
+ *
+ */
+static bool pidfd_exited(int fd, void *data) {
+    events_unwatch(fd);
+    (void)close(fd);
+    for (int i = 0; i < num_watches; i++) {
+        if (watches[i]->pidfd == fd) {
+            watches[i]->pidfd = -1;
+            watches[i]->valid = false;
+        }
+    }
+    return true;
+}
+
+static pidfile_watch_t *pidfile_watch(const char *path) {
+    for (int i = 0; i < num_watches; i++) {
+        if (strcmp(watches[i]->path, path) == 0)
+            return watches[i];
+    }
+
+    pidfile_watch_t *watch = scalloc(sizeof(pidfile_watch_t));
+    watches = srealloc(watches, (num_watches + 1) * sizeof(pidfile_watch_t *));
+    watches[num_watches++] = watch;
+    *watch = (pidfile_watch_t){.path = sstrdup(path), .resolved = resolve_tilde(path), .pidfd = -1, .valid = false};
+    return watch;
+}
+#endif
+
+/*
+ * Checks whether the process of any of the pidfiles matching path runs.
+ *
+ */
+bool process_runs(const char *path) {
+#if defined(__linux__)
+    pidfile_watch_t *watch = pidfile_watch(path);
+    /* The pidfiles are watched before they are read, so that no change gets
+     * lost in between. */
+    const bool watched = file_watch(watch->resolved, true, &watch->changes);
+    if (watch->valid && watched && watch->seen == watch->changes)
+        return watch->running;
+
+    if (watch->pidfd != -1) {
+        events_unwatch(watch->pidfd);
+        (void)close(watch->pidfd);
+        watch->pidfd = -1;
+    }
+    watch->seen = watch->changes;
+    watch->running = check_pidfiles(path, &watch->pidfd);
+    if (watch->pidfd != -1)
+        events_watch(watch->pidfd, pidfd_exited, NULL);
+
+    /* Without a watch or a pidfd, this is checked again on the next update. */
+    watch->valid = (watched && (!watch->running || watch->pidfd != -1));
+    return watch->running;
+#else
+    return check_pidfiles(path, NULL);
+#endif
+}
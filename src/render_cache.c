@@ -0,0 +1,105 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "i3status.h"
+
+/* The cache which is currently waiting for its block to be rendered, if any.
+ * Set on a cache miss, cleared once OUTPUT_FULL_TEXT recorded the text. */
+static render_cache_t *recording = NULL;
+
+/*
+ * Adds len bytes starting at data to the given fingerprint (FNV-1a).
+ *
+ */
+uint64_t fingerprint_bytes(uint64_t fingerprint, const void *data, size_t len) {
+    const unsigned char *walk = data;
+    for (size_t i = 0; i < len; i++) {
+        fingerprint ^= walk[i];
+        fingerprint *= UINT64_C(1099511628211);
+    }
+    return fingerprint;
+}
+
+/*
+ * Adds the given string (or NULL) to the fingerprint. The terminating NUL byte
+ * is included so that "ab" + "c" and "a" + "bc" do not collide.
+ *
+ */
+uint64_t fingerprint_str(uint64_t fingerprint, const char *str) {
+    if (str == NULL) {
+        const unsigned char null_marker = 0xff;
+        return fingerprint_bytes(fingerprint, &null_marker, 1);
+    }
+    return fingerprint_bytes(fingerprint, str, strlen(str) + 1);
+}
+
+/*
+ * Adds a floating point value to the fingerprint at the precision it is
+ * displayed with, so that changes hidden by rounding still hit the cache.
+ *
+ */
+uint64_t fingerprint_rounded(uint64_t fingerprint, double value, int decimals) {
+    long long rounded = fixed_point(value, decimals);
+    return fingerprint_bytes(fingerprint, &rounded, sizeof(rounded));
+}
+
+/*
+ * Looks up the render cache of the current instance. When the block was
+ * rendered from a matching fingerprint before, the cache is returned so that
+ * the module can emit it again. Otherwise, NULL is returned and the block
+ * which is rendered next is recorded under the new fingerprint.
+ *
+ */
+const render_cache_t *render_cache_lookup(uint64_t fingerprint) {
+    render_cache_t *cache = *cur_instance;
+    if (cache == NULL) {
+        cache = scalloc(sizeof(render_cache_t));
+        *cur_instance = cache;
+    }
+
+    if (cache->valid && cache->fingerprint == fingerprint) {
+        recording = NULL;
+        return cache;
+    }
+
+    cache->valid = false;
+    cache->fingerprint = fingerprint;
+    cache->color = NULL;
+    recording = cache;
+    return NULL;
+}
+
+/*
+ * Called by START_COLOR: the i3bar protocol transports the color out of band,
+ * so it needs to be remembered next to the text.
+ *
+ */
+void render_cache_record_color(const char *color) {
+    if (recording == NULL || recording != *cur_instance)
+        return;
+    recording->color = color;
+}
+
+/*
+ * Called by OUTPUT_FULL_TEXT: stores the rendered text of a block that missed
+ * the cache.
+ *
+ */
+void render_cache_record_text(const char *text) {
+    if (recording == NULL || recording != *cur_instance)
+        return;
+
+    size_t len = strlen(text) + 1;
+    if (len > recording->text_size) {
+        free(recording->full_text);
+        recording->full_text = scalloc(len);
+        recording->text_size = len;
+    }
+    memcpy(recording->full_text, text, len);
+    recording->valid = true;
+    recording = NULL;
+}
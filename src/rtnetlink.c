@@ -0,0 +1,336 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#endif
+
+#include "i3status.h"
+
+/*
+ * The network interfaces and their addresses, as announced by the kernel on
+ * a routing netlink socket. They are dumped once and then updated from the
+ * kernel's notifications, so that looking at them costs no system call, and a
+ * new line is generated as soon as an interface goes up or down or an address
+ * or IPv6 route changes.
+ *
+ */
+#if defined(__linux__)
+/* Sorted by index. */
+static net_link_t *links = NULL;
+static int num_links = 0;
+
+static net_address_t *addresses = NULL;
+static int num_addresses = 0;
+
+/* The socket which receives the notifications, or -1 if it cannot be used. */
+static int rtnetlink_fd = -1;
+
+/* Incremented whenever the tables or the IPv6 routes change. */
+static unsigned int generation = 0;
+
+static int find_link(int index) {
+    for (int i = 0; i < num_links; i++) {
+        if (links[i].index == index)
+            return i;
+    }
+    return -1;
+}
+
+static int find_address(const net_address_t *address) {
+    for (int i = 0; i < num_addresses; i++) {
+        const net_address_t *other = &addresses[i];
+        if (other->index == address->index && other->family == address->family &&
+            other->prefixlen == address->prefixlen && memcmp(other->address, address->address, sizeof(other->address)) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static bool update_link(const struct nlmsghdr *hdr) {
+    const struct ifinfomsg *info = NLMSG_DATA(hdr);
+    net_link_t link = {.index = info->ifi_index, .flags = info->ifi_flags};
+    int len = IFLA_PAYLOAD(hdr);
+    for (const struct rtattr *attr = IFLA_RTA(info); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFLA_IFNAME)
+            snprintf(link.name, sizeof(link.name), "%s", (const char *)RTA_DATA(attr));
+    }
+
+    int i = find_link(link.index);
+    if (hdr->nlmsg_type == RTM_DELLINK) {
+        if (i == -1)
+            return false;
+        memmove(&links[i], &links[i + 1], (num_links - i - 1) * sizeof(net_link_t));
+        num_links--;
+        int kept = 0;
+        for (int j = 0; j < num_addresses; j++) {
+            if (addresses[j].index != link.index)
+                addresses[kept++] = addresses[j];
+        }
+        num_addresses = kept;
+        return true;
+    }
+
+    if (i != -1) {
+        if (links[i].flags == link.flags && strcmp(links[i].name, link.name) == 0)
+            return false;
+        links[i] = link;
+        return true;
+    }
+    links = srealloc(links, (num_links + 1) * sizeof(net_link_t));
+    for (i = num_links; i > 0 && links[i - 1].index > link.index; i--)
+        links[i] = links[i - 1];
+    links[i] = link;
+    num_links++;
+    return true;
+}
+
+static bool update_address(const struct nlmsghdr *hdr) {
+    const struct ifaddrmsg *info = NLMSG_DATA(hdr);
+    net_address_t address = {.index = info->ifa_index, .family = info->ifa_family, .prefixlen = info->ifa_prefixlen};
+    if (address.family != AF_INET && address.family != AF_INET6)
+        return false;
+    /* For IPv4, IFA_LOCAL is the address of the interface, IFA_ADDRESS might
+     * be the one of the other end of a point-to-point link. */
+    const struct rtattr *local = NULL, *other = NULL;
+    int len = IFA_PAYLOAD(hdr);
+    for (const struct rtattr *attr = IFA_RTA(info); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFA_LOCAL)
+            local = attr;
+        else if (attr->rta_type == IFA_ADDRESS)
+            other = attr;
+    }
+    const struct rtattr *attr = (local != NULL ? local : other);
+    if (attr == NULL || RTA_PAYLOAD(attr) > sizeof(address.address))
+        return false;
+    memcpy(address.address, RTA_DATA(attr), RTA_PAYLOAD(attr));
+
+    /* The addresses are kept in the kernel's order, so that the primary
+     * address of an interface comes first. */
+    const int i = find_address(&address);
+    if (hdr->nlmsg_type == RTM_DELADDR) {
+        if (i == -1)
+            return false;
+        memmove(&addresses[i], &addresses[i + 1], (num_addresses - i - 1) * sizeof(net_address_t));
+        num_addresses--;
+        return true;
+    }
+    if (i != -1)
+        return false;
+    addresses = srealloc(addresses, (num_addresses + 1) * sizeof(net_address_t));
+    addresses[num_addresses++] = address;
+    return true;
+}
+
+/*
+ * Applies the given messages to the tables. Returns whether something
+ * changed, or -1 when a dump ended with an error.
+ *
+ */
+static int handle_messages(const char *buf, ssize_t n, bool *done) {
+    bool changed = false;
+    for (const struct nlmsghdr *hdr = (const struct nlmsghdr *)buf; NLMSG_OK(hdr, n); hdr = NLMSG_NEXT(hdr, n)) {
+        switch (hdr->nlmsg_type) {
+            case NLMSG_DONE:
+                *done = true;
+                break;
+            case NLMSG_ERROR:
+                *done = true;
+                return -1;
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+                changed |= update_link(hdr);
+                break;
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                changed |= update_address(hdr);
+                break;
+            case RTM_NEWROUTE:
+            case RTM_DELROUTE:
+                /* Routes are not kept, but they decide which address is used
+                 * to reach other hosts. Cached routes (e.g. for a smaller
+                 * path MTU) do not. */
+                if ((((const struct rtmsg *)NLMSG_DATA(hdr))->rtm_flags & RTM_F_CLONED) == 0)
+                    changed = true;
+                break;
+            default:
+                break;
+        }
+    }
+    return changed;
+}
+
+/*
+ * Dumps the links (RTM_GETLINK) or the addresses (RTM_GETADDR) into the
+ * tables.
+ *
+ */
+static bool dump(int type) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd == -1)
+        return false;
+
+    struct {
+        struct nlmsghdr hdr;
+        union {
+            struct ifinfomsg link;
+            struct ifaddrmsg address;
+        };
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.hdr.nlmsg_len = NLMSG_LENGTH(type == RTM_GETLINK ? sizeof(struct ifinfomsg) : sizeof(struct ifaddrmsg));
+    request.hdr.nlmsg_type = type;
+    request.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.hdr.nlmsg_seq = 1;
+    if (send(fd, &request, request.hdr.nlmsg_len, 0) == -1) {
+        (void)close(fd);
+        return false;
+    }
+
+    static char buf[32768] __attribute__((aligned(NLMSG_ALIGNTO)));
+    bool done = false;
+    while (!done) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0 || handle_messages(buf, n, &done) == -1) {
+            (void)close(fd);
+            return false;
+        }
+    }
+    (void)close(fd);
+    return true;
+}
+
+static bool dump_all(void) {
+    num_links = 0;
+    num_addresses = 0;
+    generation++;
+    return dump(RTM_GETLINK) && dump(RTM_GETADDR);
+}
+
+/*
+ * Reads the pending notifications. Returns whether an interface or address
+ * changed.
+ *
+ */
+static bool read_notifications(int fd, void *data) {
+    static char buf[32768] __attribute__((aligned(NLMSG_ALIGNTO)));
+    bool changed = false;
+    while (true) {
+        struct sockaddr_nl sender;
+        socklen_t sender_len = sizeof(sender);
+        ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&sender, &sender_len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ENOBUFS) {
+                /* Notifications were dropped, so the tables are dumped
+                 * again. */
+                if (!dump_all()) {
+                    events_unwatch(fd);
+                    (void)close(fd);
+                    rtnetlink_fd = -1;
+                    return true;
+                }
+                changed = true;
+                continue;
+            }
+            return changed;
+        }
+        /* Only the kernel is trusted to announce interfaces. */
+        if (sender.nl_pid != 0)
+            continue;
+        bool done = false;
+        if (handle_messages(buf, n, &done) == 1) {
+            generation++;
+            changed = true;
+        }
+    }
+}
+
+/*
+ * Subscribes to the notifications about interfaces, addresses and IPv6 routes
+ * and dumps
+ * the current ones. Returns false if they are not available.
+ *
+ */
+static bool open_rtnetlink(void) {
+    static bool opened = false;
+    if (opened)
+        return (rtnetlink_fd != -1);
+    opened = true;
+
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd == -1)
+        return false;
+    /* Subscribe before dumping, so that no change gets lost. */
+    struct sockaddr_nl addr = {.nl_family = AF_NETLINK, .nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV6_ROUTE};
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || !dump_all()) {
+        (void)close(fd);
+        return false;
+    }
+    rtnetlink_fd = fd;
+    events_watch(fd, read_notifications, NULL);
+    return true;
+}
+#endif
+
+/*
+ * Returns the network interfaces, sorted by their index. Returns false if
+ * they are not available through netlink, in which case callers have to ask
+ * the system themselves (e.g. with getifaddrs()).
+ *
+ */
+bool rtnetlink_links(const net_link_t **result, int *num) {
+#if defined(__linux__)
+    if (!open_rtnetlink())
+        return false;
+    *result = links;
+    *num = num_links;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Returns the IPv4 and IPv6 addresses of all network interfaces, like
+ * rtnetlink_links().
+ *
+ */
+bool rtnetlink_addresses(const net_address_t **result, int *num) {
+#if defined(__linux__)
+    if (!open_rtnetlink())
+        return false;
+    *result = addresses;
+    *num = num_addresses;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Returns a number which changes whenever an interface, an address or an IPv6
+ * route changes, so that callers can keep what they derive from them until
+ * then. Returns false if the changes are not followed through netlink.
+ *
+ */
+bool rtnetlink_generation(unsigned int *result) {
+#if defined(__linux__)
+    if (!open_rtnetlink())
+        return false;
+    *result = generation;
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,167 @@
+// vim:ts=4:sw=4:expandtab
+#include <config.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#endif
+
+#include "i3status.h"
+
+/*
+ * The kernel announces devices which are added, removed or changed (e.g. a
+ * battery which starts charging) as uevents on a netlink socket. Modules
+ * register the subsystems they are interested in and get the events counted,
+ * so that they know when to look at sysfs again.
+ *
+ */
+#if defined(__linux__)
+typedef struct {
+    char *subsystem;
+    uevent_counts_t *counts;
+    bool redraw;
+} uevent_watch_t;
+
+static uevent_watch_t *watches = NULL;
+static int num_watches = 0;
+
+/* The socket, or -1 if it cannot be used. */
+static int uevent_fd = -1;
+
+static void count_uevent(uevent_counts_t *counts, const char *action) {
+    counts->changes++;
+    if (action == NULL || strcmp(action, "add") == 0 || strcmp(action, "remove") == 0)
+        counts->hotplugs++;
+}
+
+/*
+ * Closes the cached files (see fd_cache_pread()) of a device which was added
+ * or removed, both below its device path and its class directory, so that a
+ * path which now belongs to another device is not read from the old one.
+ *
+ */
+static void invalidate_device(const char *subsystem, const char *devpath) {
+    char prefix[PATH_MAX];
+    snprintf(prefix, sizeof(prefix), "/sys%s/", devpath);
+    fd_cache_invalidate(prefix);
+    const char *name = strrchr(devpath, '/');
+    snprintf(prefix, sizeof(prefix), "/sys/class/%s/%s/", subsystem, (name != NULL ? name + 1 : devpath));
+    fd_cache_invalidate(prefix);
+}
+
+/*
+ * Reads the pending uevents and counts those of the watched subsystems.
+ * Returns whether one of them should be shown right away.
+ *
+ */
+static bool read_uevents(int fd, void *data) {
+    char buf[8192];
+    bool redraw = false;
+    while (true) {
+        struct sockaddr_nl sender;
+        struct iovec iov = {.iov_base = buf, .iov_len = sizeof(buf) - 1};
+        struct msghdr msg = {.msg_name = &sender, .msg_namelen = sizeof(sender), .msg_iov = &iov, .msg_iovlen = 1};
+        ssize_t n = recvmsg(fd, &msg, 0);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ENOBUFS) {
+                /* Events were dropped, so anything might have changed. */
+                fd_cache_invalidate("/sys/");
+                for (int i = 0; i < num_watches; i++) {
+                    count_uevent(watches[i].counts, NULL);
+                    redraw |= watches[i].redraw;
+                }
+                continue;
+            }
+            return redraw;
+        }
+        /* Only the kernel is trusted to announce devices. */
+        if (sender.nl_pid != 0)
+            continue;
+
+        /* The message is "action@devpath" followed by KEY=VALUE properties,
+         * each terminated by a 0 byte. */
+        buf[n] = '\0';
+        const char *action = NULL, *subsystem = NULL, *devpath = NULL;
+        for (const char *walk = buf + strlen(buf) + 1; walk < buf + n; walk += strlen(walk) + 1) {
+            if (BEGINS_WITH(walk, "ACTION="))
+                action = walk + strlen("ACTION=");
+            else if (BEGINS_WITH(walk, "SUBSYSTEM="))
+                subsystem = walk + strlen("SUBSYSTEM=");
+            else if (BEGINS_WITH(walk, "DEVPATH="))
+                devpath = walk + strlen("DEVPATH=");
+        }
+        if (action == NULL || subsystem == NULL)
+            continue;
+
+        if (devpath != NULL && (strcmp(action, "add") == 0 || strcmp(action, "remove") == 0))
+            invalidate_device(subsystem, devpath);
+
+        for (int i = 0; i < num_watches; i++) {
+            if (strcmp(watches[i].subsystem, subsystem) != 0)
+                continue;
+            count_uevent(watches[i].counts, action);
+            redraw |= watches[i].redraw;
+        }
+    }
+}
+
+/*
+ * Subscribes to the uevents of the kernel. Returns false if they cannot be
+ * received.
+ *
+ */
+static bool open_uevent_socket(void) {
+    static bool opened = false;
+    if (opened)
+        return (uevent_fd != -1);
+    opened = true;
+
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd == -1)
+        return false;
+    /* Group 1 are the events of the kernel, group 2 those of udev. */
+    struct sockaddr_nl addr = {.nl_family = AF_NETLINK, .nl_groups = 1};
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        (void)close(fd);
+        return false;
+    }
+    uevent_fd = fd;
+    events_watch(fd, read_uevents, NULL);
+    return true;
+}
+#endif
+
+/*
+ * Counts the uevents of the given subsystem (e.g. "power_supply") in counts.
+ * When redraw is set, i3status generates a new line right away after such an
+ * event. Calling this again with the same arguments does nothing, so modules
+ * can call it on every update.
+ *
+ * Returns false if uevents are not available, in which case modules have to
+ * look for changes themselves.
+ *
+ */
+bool uevents_watch(const char *subsystem, uevent_counts_t *counts, bool redraw) {
+#if defined(__linux__)
+    if (!open_uevent_socket())
+        return false;
+
+    for (int i = 0; i < num_watches; i++) {
+        if (watches[i].counts == counts && strcmp(watches[i].subsystem, subsystem) == 0)
+            return true;
+    }
+    watches = srealloc(watches, (num_watches + 1) * sizeof(uevent_watch_t));
+    watches[num_watches++] = (uevent_watch_t){.subsystem = sstrdup(subsystem), .counts = counts, .redraw = redraw};
+    return true;
+#else
+    return false;
+#endif
+}